@@ -3,12 +3,20 @@
 
 enum ArgAction { ArgRun, ArgShowHelp, ArgShowAbout, ArgError };
 enum PartChoice { PartAll = 0, PartOne = 1, PartTwo = 2 };
+enum StatsChoice { StatsOff = 0, StatsShowTable, StatsShowJson };
 
 typedef struct {
   enum ArgAction action;
   unsigned char day;
   enum PartChoice part;
   const char *input_path;
+  const char *queries_path;
+  unsigned long long node_budget;
+  unsigned long long time_budget_ms;
+  unsigned threads;
+  // Day 3 Part 2 digit count; 0 keeps the puzzle's 12.
+  unsigned digits;
+  enum StatsChoice stats;
   const char *program_name;
   const char *error;
 } ArgParseResult;
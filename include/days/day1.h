@@ -1,12 +1,18 @@
 #ifndef DAY1_H
 #define DAY1_H
 
-enum Direction { Right, Left };
+#include <stddef.h>
 
-void day1RotateFastPartOne(unsigned char *value, unsigned int amount,
-                           int *counter, enum Direction dir);
+#define DAY1_DIAL_SIZE 100
 
-void day1RotateFastPartTwo(unsigned char *value, unsigned int amount,
-                           int *counter, enum Direction dir);
+typedef struct {
+  // Rotations that leave the dial on 0 (Part 1).
+  unsigned long long zeroStops;
+  // Times the dial points at 0 at any click, including mid-rotation (Part 2).
+  unsigned long long zeroClicks;
+} Day1Counts;
+
+// Applies every "L<n>"/"R<n>" line of data to a dial starting at start.
+Day1Counts day1Count(const char *data, size_t size, int start);
 
 #endif
@@ -1,7 +1,37 @@
 #ifndef DAY11_H
 #define DAY11_H
 
-unsigned long long day11Solve(const char *data);
-unsigned long long day11SolvePartTwo(const char *data);
+#include <stddef.h>
+
+typedef enum {
+  Day11Ok,
+  // Some path from the source to the target runs through a cycle.
+  Day11Cycle,
+  Day11OutOfMemory
+} Day11Status;
+
+// A parsed graph for answering many queries: the topological order is
+// computed once and per-target path tables are cached between queries. The
+// graph and its cache live in one arena of their own, freed by Destroy.
+typedef struct Day11Graph Day11Graph;
+
+// Parses data, checking the input while it is scanned. On NULL, errBuf holds
+// the message validateInputForDay would give, or is empty when memory ran
+// out.
+Day11Graph *day11GraphCreateStrict(const char *data, size_t size,
+                                   char *errBuf, size_t errBufSize);
+
+// Only the strict scan, for callers that validate without solving.
+int day11Validate(const char *data, size_t size, char *errBuf,
+                  size_t errBufSize);
+void day11GraphDestroy(Day11Graph *graph);
+
+// Counts paths from src to dst that visit every waypoint in via[] (in any
+// order). Unknown names yield 0 paths.
+Day11Status day11GraphCountPaths(Day11Graph *graph, const char *src,
+                                 const char *dst, const char *const *via,
+                                 int viaCount, unsigned long long *out);
+
+const char *day11StatusMessage(Day11Status status);
 
 #endif
@@ -1,6 +1,39 @@
 #ifndef DAY12_H
 #define DAY12_H
 
+#include <stddef.h>
+
+typedef struct {
+  // Search nodes one region may expand before it is left undecided
+  // (0 = unlimited).
+  unsigned long long nodeBudget;
+  // Wall-clock milliseconds one region may search (0 = unlimited).
+  unsigned long long timeBudgetMs;
+  // Cancel the remaining regions once one is undecided, for callers that
+  // only want an exact count.
+  int stopWhenUndecided;
+} Day12Limits;
+
+typedef struct {
+  unsigned long long fit;
+  // Regions that ran out of budget or are too large to search, and regions
+  // never started because the run was cancelled.
+  unsigned long long undecided;
+  unsigned long long skipped;
+} Day12Result;
+
+// Evaluates every region on the worker pool; limits may be NULL.
+Day12Result day12Count(const char *data, const Day12Limits *limits);
+
+// day12Count with the input checked while it is parsed: returns 0, with the
+// message validateInputForDay would give in errBuf, when it is malformed.
+int day12CountStrict(const char *data, size_t size, const Day12Limits *limits,
+                     Day12Result *out, char *errBuf, size_t errBufSize);
+
+// Only the strict parse, for callers that validate without solving.
+int day12Validate(const char *data, size_t size, char *errBuf,
+                  size_t errBufSize);
+
 unsigned long long day12Solve(const char *data);
 unsigned long long day12SolvePartTwo(const char *data);
 
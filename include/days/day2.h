@@ -1,8 +1,23 @@
 #ifndef DAY2_H
 #define DAY2_H
 
-unsigned long long day2Solve(const char *data);
+#include <stddef.h>
 
-unsigned long long day2SolvePartTwo(const char *data);
+// Range bounds may be anything up to 2^128 - 1; totals are kept exactly in
+// 256 bits, least significant limb first.
+#define DAY2_TOTAL_LIMBS 4
+#define DAY2_TOTAL_DIGITS 78
+
+typedef struct {
+  unsigned long long limbs[DAY2_TOTAL_LIMBS];
+} Day2Total;
+
+Day2Total day2Solve(const char *data);
+
+Day2Total day2SolvePartTwo(const char *data);
+
+// Writes the decimal form of total into buf (DAY2_TOTAL_DIGITS + 1 bytes is
+// always enough) and returns buf.
+const char *day2FormatTotal(Day2Total total, char *buf, size_t size);
 
 #endif
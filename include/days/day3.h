@@ -1,8 +1,17 @@
 #ifndef DAY3_H
 #define DAY3_H
 
-unsigned long long day3Solve(const char *data);
+#include <stddef.h>
 
-unsigned long long day3SolvePartTwo(const char *data);
+// Largest k a bank value can use without overflowing 64 bits.
+#define DAY3_MAX_DIGITS 19
+
+unsigned long long day3Solve(const char *data, size_t size);
+
+unsigned long long day3SolvePartTwo(const char *data, size_t size);
+
+// Sum over all lines of the largest k-digit subsequence (Part 2 uses k = 12;
+// --digits picks another). Returns 0 when k is outside [1, DAY3_MAX_DIGITS].
+unsigned long long day3SolveK(const char *data, size_t size, int k);
 
 #endif
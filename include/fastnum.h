@@ -0,0 +1,42 @@
+#ifndef FASTNUM_H
+#define FASTNUM_H
+
+#include "tools.h"
+
+#include <stddef.h>
+
+// Decimal parsing for the solvers' hot loops. Every function reads only
+// [*cursor, end), takes no locale into account, and rejects values that do
+// not fit rather than wrapping or saturating.
+
+ARENA_VEC(U64Vec, unsigned long long)
+ARENA_VEC(I64Vec, long long)
+
+// Parses the digits at *cursor (eight at a time where the buffer allows) and
+// advances *cursor past them. Returns 0 and leaves *cursor alone when there
+// is no digit or the value overflows.
+int fastParseU64(const char **cursor, const char *end,
+                 unsigned long long *out);
+
+// Like fastParseU64, with an optional leading '-' or '+'. Leading blanks
+// are skipped as strtol would, so "x, y" fields parse as the validators
+// accept them.
+int fastParseI64(const char **cursor, const char *end, long long *out);
+
+// Advances p past spaces and tabs.
+static inline const char *fastSkipBlanks(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    p++;
+  }
+  return p;
+}
+
+// Appends every number in [p, end) to out. Numbers are separated by commas
+// and/or whitespace; anything else, or a value that overflows, stops the
+// parse and returns 0 (as does running out of memory).
+int fastParseU64List(const char *p, const char *end, Arena *arena,
+                     U64Vec *out);
+int fastParseI64List(const char *p, const char *end, Arena *arena,
+                     I64Vec *out);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef LINES_H
+#define LINES_H
+
+#include "tools.h"
+
+#include <stddef.h>
+
+// Where every line of a buffer ends, found without touching the buffer.
+// ends[i] is the offset of line i's '\n', or the buffer size for a last line
+// without one; line i starts right after line i - 1's end. A trailing '\n'
+// does not open an empty last line, so "a\nb\n" and "a\nb" both have 2 lines.
+typedef struct {
+  const char *data;
+  const size_t *ends;
+  size_t count;
+} LineIndex;
+
+// Indexes data[0, size) into arena. Newlines are found 64 bytes at a time
+// with vector compares and movemasks; buffers large enough to be worth it
+// are scanned by the worker pool in independent byte ranges. Returns 0 when
+// out of memory.
+int lineIndexBuild(LineIndex *index, const char *data, size_t size,
+                   Arena *arena);
+
+static inline size_t lineStart(const LineIndex *index, size_t line) {
+  return line == 0 ? 0 : index->ends[line - 1] + 1;
+}
+
+// Length of line i, excluding its '\n'.
+static inline size_t lineLength(const LineIndex *index, size_t line) {
+  return index->ends[line] - lineStart(index, line);
+}
+
+// First line of range `chunk` of `chunks`, for splitting the lines evenly
+// between workers; chunk == chunks yields index->count.
+static inline size_t lineChunkStart(const LineIndex *index, size_t chunks,
+                                    size_t chunk) {
+  return chunk >= chunks ? index->count : index->count * chunk / chunks;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Worker threads the parallel helpers may use (always >= 1). Defaults to the
+// number of online CPUs; --threads overrides it.
+int parallelThreadCount(void);
+
+void parallelSetThreadCount(int count);
+
+// Frees the per-worker scratch arenas. Call once no pool run is active; a
+// later run recreates them.
+void parallelShutdown(void);
+
+typedef void (*ParallelTaskFn)(void *ctx, size_t task, int worker);
+
+// Runs fn(ctx, task, worker) for every task in [0, taskCount) and returns once
+// all of them finished. Each worker takes one contiguous block of tasks; the
+// calling thread works as worker 0. `worker` is below parallelThreadCount().
+// Every task runs inside its own frame of arenaScratch(), which for spawned
+// workers is a per-worker arena reused across calls.
+void parallelFor(size_t taskCount, ParallelTaskFn fn, void *ctx);
+
+// Like parallelFor, but workers claim one task at a time from a shared
+// counter, so a few slow tasks cannot leave the other workers idle. Once
+// *cancel (if non-NULL) becomes non-zero no further tasks are started.
+void parallelForDynamic(size_t taskCount, ParallelTaskFn fn, void *ctx,
+                        atomic_int *cancel);
+
+// Number of chunks to split size bytes into: one per thread, but none smaller
+// than minBytes. Returns 1 when the input should be processed serially.
+size_t parallelChunkCount(size_t size, size_t minBytes);
+
+// Start of chunk `chunk` (of `chunks`) of data[0, size). Nominal byte offsets
+// are pushed forward past the next newline, so every line belongs to exactly
+// one chunk; chunk == chunks yields data + size.
+const char *parallelLineChunk(const char *data, size_t size, size_t chunks,
+                              size_t chunk);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+// Counters and timers that explain what the solvers did on a given input.
+// They only exist in builds with -DAOC_STATS (make STATS=1); otherwise every
+// macro below expands to nothing and the hot paths are unchanged.
+//
+// Each thread counts into its own slots; pool tasks fold theirs into the
+// shared totals when they finish, so counting never contends.
+
+#define STATS_COUNTERS(X)                                                      \
+  X(D8_HEAP_REPLACEMENTS, "day8.heap_replacements")                           \
+  X(D10_LIGHT_COMBOS, "day10.light_combos")                                   \
+  X(D10_BNB_NODES, "day10.bnb_nodes")                                         \
+  X(D10_SIMPLEX_PIVOTS, "day10.simplex_pivots")                               \
+  X(D11_TABLE_HITS, "day11.table_hits")                                       \
+  X(D11_TABLE_BUILDS, "day11.table_builds")                                   \
+  X(D12_SEARCH_NODES, "day12.search_nodes")                                   \
+  X(D12_DEAD_HITS, "day12.dead_hits")                                         \
+  X(D12_DEAD_STORES, "day12.dead_stores")                                     \
+  X(D12_SPLIT_SUBTREES, "day12.split_subtrees")
+
+#define STATS_TIMERS(X)                                                        \
+  X(VALIDATE, "run.validate")                                                 \
+  X(SOLVE, "run.solve")                                                       \
+  X(D10_LP_RELAX, "day10.lp_relax")                                           \
+  X(D12_PLACEMENT_TABLES, "day12.placement_tables")
+
+#define STATS_ENUM_ENTRY(id, name) STAT_##id,
+typedef enum { STATS_COUNTERS(STATS_ENUM_ENTRY) STAT_COUNTER_COUNT } StatCounter;
+#undef STATS_ENUM_ENTRY
+#define STATS_ENUM_ENTRY(id, name) STAT_TIMER_##id,
+typedef enum { STATS_TIMERS(STATS_ENUM_ENTRY) STAT_TIMER_COUNT } StatTimer;
+#undef STATS_ENUM_ENTRY
+
+typedef enum { StatsTable, StatsJson } StatsFormat;
+
+// Whether this build collects anything.
+int statsEnabled(void);
+
+// Adds the calling thread's counts to the totals and clears them.
+void statsFlush(void);
+
+// Flushes the calling thread and prints every total.
+void statsPrint(FILE *out, StatsFormat format);
+
+#ifdef AOC_STATS
+
+typedef struct {
+  unsigned long long counters[STAT_COUNTER_COUNT];
+  unsigned long long timerNs[STAT_TIMER_COUNT];
+  unsigned long long timerCalls[STAT_TIMER_COUNT];
+} StatsSlots;
+
+extern _Thread_local StatsSlots statsLocal;
+
+unsigned long long statsNowNs(void);
+
+#define STATS_FLUSH() statsFlush()
+#define STAT_ADD(id, n) (statsLocal.counters[STAT_##id] += (n))
+#define STAT_INC(id) STAT_ADD(id, 1)
+// A timer covers the code between START and STOP in the same scope.
+#define STAT_TIMER_START(id)                                                   \
+  const unsigned long long statStart_##id = statsNowNs()
+#define STAT_TIMER_STOP(id)                                                    \
+  do {                                                                         \
+    statsLocal.timerNs[STAT_TIMER_##id] += statsNowNs() - statStart_##id;     \
+    statsLocal.timerCalls[STAT_TIMER_##id]++;                                 \
+  } while (0)
+
+#else
+
+#define STATS_FLUSH() ((void)0)
+#define STAT_ADD(id, n) ((void)0)
+#define STAT_INC(id) ((void)0)
+#define STAT_TIMER_START(id) ((void)0)
+#define STAT_TIMER_STOP(id) ((void)0)
+
+#endif
+
+#endif
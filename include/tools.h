@@ -4,22 +4,101 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+typedef struct ArenaBlock ArenaBlock;
+
+// Bump allocator over a chain of blocks. base/capacity/offset describe the
+// block currently being filled; when it runs out a spare block from an
+// earlier release is reused, or a new one at least twice as large is added.
 typedef struct {
   unsigned char *base;
   size_t capacity;
   size_t offset;
+  ArenaBlock *block;
 } Arena;
 
+// A point in an arena to roll back to; everything allocated after it is
+// released at once.
+typedef struct {
+  ArenaBlock *block;
+  size_t offset;
+} ArenaMark;
+
 Arena arenaCreate(size_t capacity);
 
+// Aligned to max_align_t. Returns NULL only when the system is out of memory.
 void *arenaAlloc(Arena *arena, size_t size);
 
+// align must be a power of two.
+void *arenaAllocAligned(Arena *arena, size_t size, size_t align);
+
+// Zeroed array of count elements; NULL on overflow or out of memory.
+void *arenaAllocZero(Arena *arena, size_t count, size_t size);
+
+// Grows (or shrinks) the most recent allocation in place when it is the last
+// thing in its block; otherwise copies it into a fresh allocation.
+void *arenaRealloc(Arena *arena, void *ptr, size_t oldSize, size_t newSize);
+
+// Slow path of the ARENA_VEC push: makes room for at least minCapacity
+// elements, doubling the capacity (minimum 8). The array is extended in
+// place when it is the newest allocation in the arena, otherwise moved; the
+// old copy is left to the enclosing frame. Returns 0 when out of memory.
+int arenaVecGrow(Arena *arena, void **items, size_t *capacity,
+                 size_t elemSize, size_t minCapacity);
+
+// Declares Name, a growable array of T backed by an arena, with
+//   int NameReserve(Arena *, Name *, size_t capacity)
+//   int NamePush(Arena *, Name *, T value)
+// both returning 0 when out of memory. A zeroed Name is empty. Keep one
+// array growing at a time where possible: only the newest allocation grows
+// in place.
+#define ARENA_VEC(Name, T)                                                    \
+  typedef struct {                                                            \
+    T *items;                                                                 \
+    size_t count;                                                             \
+    size_t capacity;                                                          \
+  } Name;                                                                     \
+                                                                              \
+  static inline int Name##Reserve(Arena *arena, Name *vec, size_t capacity) { \
+    if (capacity <= vec->capacity) {                                          \
+      return 1;                                                               \
+    }                                                                         \
+    void *items = vec->items;                                                 \
+    if (!arenaVecGrow(arena, &items, &vec->capacity, sizeof(T), capacity)) {  \
+      return 0;                                                               \
+    }                                                                         \
+    vec->items = items;                                                       \
+    return 1;                                                                 \
+  }                                                                           \
+                                                                              \
+  static inline int Name##Push(Arena *arena, Name *vec, T value) {            \
+    if (vec->count == vec->capacity &&                                        \
+        !Name##Reserve(arena, vec, vec->count + 1)) {                         \
+      return 0;                                                               \
+    }                                                                         \
+    vec->items[vec->count++] = value;                                         \
+    return 1;                                                                 \
+  }
+
+ArenaMark arenaMark(const Arena *arena);
+
+// Rolls back to mark. Blocks added since are kept for reuse, not freed.
+void arenaRelease(Arena *arena, ArenaMark mark);
+
 void arenaReset(Arena *arena);
 
 void arenaDestroy(Arena *arena);
 
+// The calling thread's scratch arena. Solvers take their temporary buffers
+// from it inside an arenaMark/arenaRelease frame. main installs its own
+// arena; parallelFor workers get one per worker; any other thread falls back
+// to a lazily created arena of its own.
+Arena *arenaScratch(void);
+
+void arenaSetScratch(Arena *arena);
+
 char *readFile(const char *fileName, size_t *outSize, Arena *arena);
 
+// Splits fileContent in place at its newlines (see lineIndexBuild).
 char **getLines(char *fileContent, size_t *outCount, Arena *arena);
 
 static inline int isDigit(char c) {
@@ -27,8 +106,6 @@ static inline int isDigit(char c) {
   return v - (unsigned char)'0' <= 9u;
 }
 
-unsigned long long parseULL(const char *s, const char **endOut);
-
 static const int NEIGHBOR_DX[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
 static const int NEIGHBOR_DY[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
 
@@ -9,4 +9,18 @@
 int validateInputForDay(unsigned int day, const char *data, size_t size,
                         char *errBuf, size_t errBufSize);
 
+// Days whose solvers have a strict parse that reports the same errors while
+// building their input structure, so a caller about to solve them can skip
+// the separate validation scan.
+int validateFusedWithParse(unsigned int day);
+
+// Where a strict parser writes the first problem it finds.
+typedef struct {
+  char *buf;
+  size_t size;
+} ParseError;
+
+// Writes msg to err and returns 0, for `return parseFail(err, "...")`.
+int parseFail(const ParseError *err, const char *msg);
+
 #endif
@@ -1,5 +1,6 @@
 #include "cli.h"
 #include "color.h"
+#include "days/day3.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,6 +24,12 @@ void printHelp(const char *programName, const char *defaultInput) {
   char optDay[160];
   char optPart[160];
   char optInput[160];
+  char optThreads[160];
+  char optQueries[160];
+  char optDigits[160];
+  char optNodes[160];
+  char optTime[160];
+  char optStats[160];
   char optHelp[96];
   char optVersion[96];
 
@@ -42,14 +49,34 @@ void printHelp(const char *programName, const char *defaultInput) {
   snprintf(optInput, sizeof(optInput),
            "  %s-i%s, %s--input PATH%s  Input file (default: %s)", p->accent,
            p->reset, p->accent, p->reset, defaultInput);
+  snprintf(optThreads, sizeof(optThreads),
+           "  %s-t%s, %s--threads N%s   Worker threads (default: all cores)",
+           p->accent, p->reset, p->accent, p->reset);
+  snprintf(optQueries, sizeof(optQueries),
+           "  %s-q%s, %s--queries PATH%s Day 11: answer 'src dst [via...]' lines",
+           p->accent, p->reset, p->accent, p->reset);
+  snprintf(optDigits, sizeof(optDigits),
+           "      %s--digits K%s       Day 3: Part 2 picks K digits (default: 12)",
+           p->accent, p->reset);
+  snprintf(optNodes, sizeof(optNodes),
+           "      %s--node-budget N%s  Day 12: search nodes per region",
+           p->accent, p->reset);
+  snprintf(optTime, sizeof(optTime),
+           "      %s--time-budget MS%s Day 12: milliseconds per region",
+           p->accent, p->reset);
+  snprintf(optStats, sizeof(optStats),
+           "      %s--stats [FMT]%s   Print counters as {table|json} (STATS=1)",
+           p->accent, p->reset);
   snprintf(optHelp, sizeof(optHelp),
            "  %s-h%s, %s--help%s        Show this help message", p->warn,
            p->reset, p->warn, p->reset);
   snprintf(optVersion, sizeof(optVersion),
            "  %s-a%s, %s--about%s       Show about information", p->warn,
            p->reset, p->warn, p->reset);
-  const char *info[] = {header,  usage,  options, optDay,
-                        optPart, optInput, optHelp, optVersion};
+  const char *info[] = {header,     usage,      options, optDay,
+                        optPart,    optInput,   optThreads, optQueries,
+                        optDigits,  optNodes,   optTime,    optStats,
+                        optHelp,    optVersion};
 
   const size_t treeCount = sizeof(tree) / sizeof(tree[0]);
   const size_t infoCount = sizeof(info) / sizeof(info[0]);
@@ -88,6 +115,20 @@ void printHelp(const char *programName, const char *defaultInput) {
   }
 }
 
+// Positive decimal budget; 0 and junk are rejected.
+static int parseBudget(const char *value, unsigned long long *out) {
+  char *end;
+  if (*value < '0' || *value > '9') {
+    return 0;
+  }
+  unsigned long long parsed = strtoull(value, &end, 10);
+  if (end == value || *end != '\0' || parsed == 0) {
+    return 0;
+  }
+  *out = parsed;
+  return 1;
+}
+
 ArgParseResult parseArgs(int argc, char **argv, const char *defaultInput) {
   static char errorBuf[128];
 
@@ -96,6 +137,12 @@ ArgParseResult parseArgs(int argc, char **argv, const char *defaultInput) {
       .day = 0,
       .part = PartAll,
       .input_path = defaultInput,
+      .queries_path = NULL,
+      .node_budget = 0,
+      .time_budget_ms = 0,
+      .threads = 0,
+      .digits = 0,
+      .stats = StatsOff,
       .program_name = baseName(argv[0]),
       .error = NULL,
   };
@@ -124,6 +171,50 @@ ArgParseResult parseArgs(int argc, char **argv, const char *defaultInput) {
       continue;
     }
 
+    if (strcmp(arg, "--queries") == 0 || strcmp(arg, "-q") == 0) {
+      if (i + 1 >= argc) {
+        snprintf(errorBuf, sizeof(errorBuf), "Missing path after %s", arg);
+        result.action = ArgError;
+        result.error = errorBuf;
+        return result;
+      }
+      result.queries_path = argv[++i];
+      continue;
+    }
+
+    if (strcmp(arg, "--node-budget") == 0 ||
+        strcmp(arg, "--time-budget") == 0) {
+      int nodes = strcmp(arg, "--node-budget") == 0;
+      if (i + 1 >= argc) {
+        snprintf(errorBuf, sizeof(errorBuf), "Missing %s after %s",
+                 nodes ? "count" : "milliseconds", arg);
+        result.action = ArgError;
+        result.error = errorBuf;
+        return result;
+      }
+      const char *value = argv[++i];
+      if (!parseBudget(value, nodes ? &result.node_budget
+                                    : &result.time_budget_ms)) {
+        snprintf(errorBuf, sizeof(errorBuf), "Invalid budget: %s", value);
+        result.action = ArgError;
+        result.error = errorBuf;
+        return result;
+      }
+      continue;
+    }
+
+    // The format is optional, so only a known one is taken as its value.
+    if (strcmp(arg, "--stats") == 0) {
+      result.stats = StatsShowTable;
+      if (i + 1 < argc && strcmp(argv[i + 1], "table") == 0) {
+        i++;
+      } else if (i + 1 < argc && strcmp(argv[i + 1], "json") == 0) {
+        result.stats = StatsShowJson;
+        i++;
+      }
+      continue;
+    }
+
     if (strcmp(arg, "--day") == 0 || strcmp(arg, "-d") == 0) {
       if (i + 1 >= argc) {
         snprintf(errorBuf, sizeof(errorBuf), "Missing day after %s", arg);
@@ -144,6 +235,49 @@ ArgParseResult parseArgs(int argc, char **argv, const char *defaultInput) {
       continue;
     }
 
+    if (strcmp(arg, "--threads") == 0 || strcmp(arg, "-t") == 0) {
+      if (i + 1 >= argc) {
+        snprintf(errorBuf, sizeof(errorBuf), "Missing count after %s", arg);
+        result.action = ArgError;
+        result.error = errorBuf;
+        return result;
+      }
+      const char *value = argv[++i];
+      char *end;
+      unsigned long parsed = strtoul(value, &end, 10);
+      if (end == value || *end != '\0' || parsed == 0 || parsed > 256UL) {
+        snprintf(errorBuf, sizeof(errorBuf), "Invalid thread count: %s",
+                 value);
+        result.action = ArgError;
+        result.error = errorBuf;
+        return result;
+      }
+      result.threads = (unsigned)parsed;
+      continue;
+    }
+
+    if (strcmp(arg, "--digits") == 0) {
+      if (i + 1 >= argc) {
+        snprintf(errorBuf, sizeof(errorBuf), "Missing count after %s", arg);
+        result.action = ArgError;
+        result.error = errorBuf;
+        return result;
+      }
+      const char *value = argv[++i];
+      char *end;
+      unsigned long parsed = strtoul(value, &end, 10);
+      if (end == value || *end != '\0' || parsed == 0 ||
+          parsed > (unsigned long)DAY3_MAX_DIGITS) {
+        snprintf(errorBuf, sizeof(errorBuf), "Invalid digit count: %s",
+                 value);
+        result.action = ArgError;
+        result.error = errorBuf;
+        return result;
+      }
+      result.digits = (unsigned)parsed;
+      continue;
+    }
+
     if (strcmp(arg, "--part") == 0 || strcmp(arg, "-p") == 0) {
       if (i + 1 >= argc) {
         snprintf(errorBuf, sizeof(errorBuf), "Missing part after %s", arg);
@@ -180,5 +314,30 @@ ArgParseResult parseArgs(int argc, char **argv, const char *defaultInput) {
     return result;
   }
 
+  if (result.action == ArgRun && result.queries_path && result.day != 11) {
+    snprintf(errorBuf, sizeof(errorBuf),
+             "--queries is only supported for day 11");
+    result.action = ArgError;
+    result.error = errorBuf;
+    return result;
+  }
+
+  if (result.action == ArgRun && result.digits && result.day != 3) {
+    snprintf(errorBuf, sizeof(errorBuf),
+             "--digits is only supported for day 3");
+    result.action = ArgError;
+    result.error = errorBuf;
+    return result;
+  }
+
+  if (result.action == ArgRun &&
+      (result.node_budget || result.time_budget_ms) && result.day != 12) {
+    snprintf(errorBuf, sizeof(errorBuf),
+             "--node-budget/--time-budget are only supported for day 12");
+    result.action = ArgError;
+    result.error = errorBuf;
+    return result;
+  }
+
   return result;
 }
@@ -1,55 +1,270 @@
 #include "days/day1.h"
 
-void day1RotateFastPartOne(unsigned char *value, unsigned int amount,
-                           int *counter, enum Direction dir) {
-  int pos = *value;
-  if (dir == Right) {
-    pos += (int)amount;
-    if (pos >= 100) {
-      pos %= 100;
+#include "parallel.h"
+#include "tools.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+enum {
+  // Deltas parsed per batch; small enough to stay in L1 between the parse and
+  // the position kernel.
+  D1_BATCH = 4096,
+  // Inputs smaller than this per extra thread are folded serially.
+  D1_PARALLEL_MIN_BYTES = 1 << 20
+};
+
+// Parses up to cap rotations into signed deltas in (-100, 100). Whole turns
+// never move the dial but pass 0 once each, so they go straight into the
+// Part 2 count.
+static size_t parseDeltas(const char **cursor, const char *end,
+                          signed char *deltas, size_t cap,
+                          unsigned long long *zeroClicks) {
+  const char *p = *cursor;
+  size_t count = 0;
+  while (p < end && count < cap) {
+    char dir = *p++;
+    unsigned long long amount = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+      amount = amount * 10ULL + (unsigned long long)(*p - '0');
+      p++;
     }
-  } else {
-    pos -= (int)amount;
-    if (pos < 0) {
-      pos = (pos % 100 + 100) % 100;
+    if (p < end && *p == '\r') {
+      p++;
+    }
+    if (p < end && *p == '\n') {
+      p++;
     }
+
+    *zeroClicks += amount / DAY1_DIAL_SIZE;
+    int delta = (int)(amount % DAY1_DIAL_SIZE);
+    deltas[count++] = (signed char)(dir == 'R' ? delta : -delta);
+  }
+  *cursor = p;
+  return count;
+}
+
+// A step from pos by delta passes (or lands on) 0 when moving right past 99,
+// or when moving left from a non-zero position down to 0 or below.
+static int stepScalar(int pos, int delta, Day1Counts *counts) {
+  int next = pos + delta;
+  if (delta > 0 ? next >= DAY1_DIAL_SIZE : (pos > 0 && next <= 0)) {
+    counts->zeroClicks++;
+  }
+  if (next >= DAY1_DIAL_SIZE) {
+    next -= DAY1_DIAL_SIZE;
+  } else if (next < 0) {
+    next += DAY1_DIAL_SIZE;
   }
-  *value = (unsigned char)pos;
-  if (pos == 0) {
-    (*counter)++;
+  if (next == 0) {
+    counts->zeroStops++;
   }
+  return next;
 }
 
-void day1RotateFastPartTwo(unsigned char *value, unsigned int amount,
-                           int *counter, enum Direction dir) {
-  int start = (int)(*value);
+#ifdef __AVX2__
+// Sixteen rotations per step: an in-register prefix sum of the deltas plus
+// the carried position gives every unreduced position, which is reduced mod
+// 100 with a multiply-high. The previous position of each lane is recovered
+// as (position - delta) mod 100, so both counts are plain lane compares.
+static int rotateBlock(const signed char *deltas, size_t count, int pos,
+                       Day1Counts *counts, size_t *done) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi16(1);
+  const __m256i dial = _mm256_set1_epi16(DAY1_DIAL_SIZE);
+  const __m256i last = _mm256_set1_epi16(DAY1_DIAL_SIZE - 1);
+  // 16 deltas sum to at most +-1584; the bias keeps the sum positive and is
+  // itself a multiple of 100.
+  const __m256i bias = _mm256_set1_epi16(16 * DAY1_DIAL_SIZE);
+  const __m256i broadcast7 = _mm256_set1_epi16(0x0F0E);
+  // (x * 5243) >> 19 == x / 100 for every x below 3300.
+  const __m256i reciprocal = _mm256_set1_epi16(5243);
 
-  unsigned int fullCycles = amount / 100;
-  unsigned int remainder = amount % 100;
+  __m256i carry = _mm256_set1_epi16((short)pos);
+  unsigned long long stopBits = 0;
+  unsigned long long clickBits = 0;
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256i d = _mm256_cvtepi8_epi16(
+        _mm_loadu_si128((const __m128i *)(deltas + i)));
+    __m256i x = _mm256_add_epi16(d, _mm256_slli_si256(d, 2));
+    x = _mm256_add_epi16(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi16(x, _mm256_slli_si256(x, 8));
+    __m256i lowTotal = _mm256_shuffle_epi8(
+        _mm256_permute2x128_si256(x, x, 0x08), broadcast7);
+    x = _mm256_add_epi16(x, lowTotal);
+    x = _mm256_add_epi16(_mm256_add_epi16(x, carry), bias);
 
-  *counter += (int)fullCycles;
+    __m256i q = _mm256_srli_epi16(_mm256_mulhi_epu16(x, reciprocal), 3);
+    __m256i p = _mm256_sub_epi16(x, _mm256_mullo_epi16(q, dial));
 
-  if (remainder > 0 && start != 0) {
-    if (dir == Right) {
-      if (remainder >= (unsigned int)(100 - start)) {
-        (*counter)++;
-      }
-    } else {
-      if (remainder >= (unsigned int)start) {
-        (*counter)++;
-      }
+    __m256i prev = _mm256_sub_epi16(p, d);
+    prev = _mm256_add_epi16(prev,
+                            _mm256_and_si256(_mm256_cmpgt_epi16(zero, prev),
+                                             dial));
+    prev = _mm256_sub_epi16(prev,
+                            _mm256_and_si256(_mm256_cmpgt_epi16(prev, last),
+                                             dial));
+    __m256i sum = _mm256_add_epi16(prev, d);
+
+    __m256i right = _mm256_and_si256(_mm256_cmpgt_epi16(d, zero),
+                                     _mm256_cmpgt_epi16(sum, last));
+    __m256i left = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpgt_epi16(zero, d),
+                         _mm256_cmpgt_epi16(prev, zero)),
+        _mm256_cmpgt_epi16(one, sum));
+
+    // movemask yields two bits per 16-bit lane; halved once at the end.
+    stopBits += (unsigned long long)__builtin_popcount(
+        (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi16(p, zero)));
+    clickBits += (unsigned long long)__builtin_popcount(
+        (unsigned)_mm256_movemask_epi8(_mm256_or_si256(right, left)));
+
+    carry = _mm256_shuffle_epi8(_mm256_permute4x64_epi64(p, 0xFF),
+                                broadcast7);
+  }
+  counts->zeroStops += stopBits / 2;
+  counts->zeroClicks += clickBits / 2;
+  *done = i;
+  return _mm256_extract_epi16(carry, 0);
+}
+#endif
+
+static Day1Counts countSerial(const char *data, size_t size, int start) {
+  Day1Counts counts = {0, 0};
+  signed char deltas[D1_BATCH];
+  const char *p = data;
+  const char *end = data + size;
+  int pos = start;
+
+  while (p < end) {
+    size_t count =
+        parseDeltas(&p, end, deltas, D1_BATCH, &counts.zeroClicks);
+    size_t i = 0;
+#ifdef __AVX2__
+    pos = rotateBlock(deltas, count, pos, &counts, &i);
+#endif
+    for (; i < count; ++i) {
+      pos = stepScalar(pos, deltas[i], &counts);
     }
   }
+  return counts;
+}
 
-  int pos;
-  if (dir == Right) {
-    pos = (start + (int)amount) % 100;
+// What a chunk does to the dial, for every possible starting position s.
+// With P the running offset from s, a step stops on 0 iff s == -P (mod 100),
+// so stops are a histogram over P; a step passes 0 for a cyclic interval of
+// s, so clicks are a difference array over s.
+typedef struct {
+  unsigned long long stopsAtOffset[DAY1_DIAL_SIZE];
+  long long clickDiff[DAY1_DIAL_SIZE + 1];
+  unsigned long long wholeTurns;
+  int net;
+} ChunkSummary;
+
+// Marks the starting positions [lo, lo + len) (mod 100) as clicking once.
+static void addClickRange(ChunkSummary *summary, int lo, int len) {
+  if (lo < 0) {
+    lo += DAY1_DIAL_SIZE;
+  }
+  summary->clickDiff[lo]++;
+  if (lo + len <= DAY1_DIAL_SIZE) {
+    summary->clickDiff[lo + len]--;
   } else {
-    pos = (start - (int)amount) % 100;
-    if (pos < 0) {
-      pos += 100;
+    summary->clickDiff[DAY1_DIAL_SIZE]--;
+    summary->clickDiff[0]++;
+    summary->clickDiff[lo + len - DAY1_DIAL_SIZE]--;
+  }
+}
+
+static void summarise(const char *data, const char *end,
+                      ChunkSummary *summary) {
+  signed char deltas[D1_BATCH];
+  const char *p = data;
+  int offset = 0;
+
+  while (p < end) {
+    size_t count =
+        parseDeltas(&p, end, deltas, D1_BATCH, &summary->wholeTurns);
+    for (size_t i = 0; i < count; ++i) {
+      int d = deltas[i];
+      // From s the dial sits at q = s + offset; right moves click for
+      // q in [100 - d, 99], left moves for q in [1, -d].
+      if (d > 0) {
+        addClickRange(summary, DAY1_DIAL_SIZE - d - offset, d);
+      } else if (d < 0) {
+        addClickRange(summary, 1 - offset, -d);
+      }
+      offset += d;
+      if (offset >= DAY1_DIAL_SIZE) {
+        offset -= DAY1_DIAL_SIZE;
+      } else if (offset < 0) {
+        offset += DAY1_DIAL_SIZE;
+      }
+      summary->stopsAtOffset[offset]++;
     }
   }
+  summary->net = offset;
+}
+
+typedef struct {
+  const char *data;
+  size_t size;
+  size_t chunks;
+  ChunkSummary *summaries;
+} ChunkBatch;
+
+static void summariseChunk(void *ctx, size_t chunk, int worker) {
+  (void)worker;
+  ChunkBatch *batch = ctx;
+  const char *begin =
+      parallelLineChunk(batch->data, batch->size, batch->chunks, chunk);
+  const char *end =
+      parallelLineChunk(batch->data, batch->size, batch->chunks, chunk + 1);
+  summarise(begin, end, &batch->summaries[chunk]);
+}
+
+// Two passes: every chunk is summarised independently as a function of its
+// starting position, then one serial pass threads the real position through
+// the summaries.
+Day1Counts day1Count(const char *data, size_t size, int start) {
+  size_t chunks = parallelChunkCount(size, D1_PARALLEL_MIN_BYTES);
+  if (chunks <= 1) {
+    return countSerial(data, size, start);
+  }
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  ChunkSummary *summaries = arenaAllocZero(scratch, chunks, sizeof(*summaries));
+  if (!summaries) {
+    return countSerial(data, size, start);
+  }
 
-  *value = (unsigned char)pos;
+  ChunkBatch batch = {
+      .data = data,
+      .size = size,
+      .chunks = chunks,
+      .summaries = summaries,
+  };
+  parallelFor(chunks, summariseChunk, &batch);
+
+  Day1Counts counts = {0, 0};
+  int pos = start;
+  for (size_t c = 0; c < chunks; ++c) {
+    const ChunkSummary *summary = &summaries[c];
+    long long clicks = 0;
+    for (int s = 0; s <= pos; ++s) {
+      clicks += summary->clickDiff[s];
+    }
+    int stopOffset = pos == 0 ? 0 : DAY1_DIAL_SIZE - pos;
+    counts.zeroStops += summary->stopsAtOffset[stopOffset];
+    counts.zeroClicks += summary->wholeTurns + (unsigned long long)clicks;
+
+    pos += summary->net;
+    if (pos >= DAY1_DIAL_SIZE) {
+      pos -= DAY1_DIAL_SIZE;
+    }
+  }
+  arenaRelease(scratch, mark);
+  return counts;
 }
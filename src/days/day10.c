@@ -1,7 +1,9 @@
 #include "days/day10.h"
 
+#include "stats.h"
+#include "tools.h"
+
 #include <stdint.h>
-#include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 
@@ -122,6 +124,7 @@ static unsigned long long solveLights(const char *line) {
     size_t combos = 1ULL << freeCount;
     uint64_t freeMasks[64];
     for (int i = 0; i < freeCount; ++i) freeMasks[i] = (1ULL << freeCols[i]);
+    STAT_ADD(D10_LIGHT_COMBOS, combos);
     for (size_t mask = 0; mask < combos; ++mask) {
       uint64_t sol = 0;
       size_t m = mask;
@@ -157,6 +160,7 @@ static unsigned long long solveLights(const char *line) {
 }
 
 unsigned long long day10Solve(const char *data) {
+  Arena *scratch = arenaScratch();
   unsigned long long total = 0;
   const char *p = data;
   while (*p) {
@@ -164,12 +168,13 @@ unsigned long long day10Solve(const char *data) {
     while (*p && *p != '\n') p++;
     size_t len = (size_t)(p - start);
     if (len > 0) {
-      char *line = malloc(len + 1);
+      ArenaMark mark = arenaMark(scratch);
+      char *line = arenaAlloc(scratch, len + 1);
       if (!line) return total;
       memcpy(line, start, len);
       line[len] = '\0';
       total += solveLights(line);
-      free(line);
+      arenaRelease(scratch, mark);
     }
     if (*p == '\n') p++;
   }
@@ -286,6 +291,7 @@ static int d10ProbAddGe(D10Problem *p, int var, double bound) {
 
 static void d10Pivot(double tab[D10_LP_MAXR][D10_LP_MAXC], int rows, int rhsCol,
                      int basic[D10_LP_MAXR], int pr, int pc) {
+  STAT_INC(D10_SIMPLEX_PIVOTS);
   double inv = 1.0 / tab[pr][pc];
   for (int j = 0; j <= rhsCol; ++j) tab[pr][j] *= inv;
   for (int i = 0; i <= rows; ++i) {
@@ -445,8 +451,12 @@ static int d10IntegerFeasible(const D10Problem *p, const double *x,
 }
 
 static void d10BnB(const D10Problem *p, double *best) {
+  STAT_INC(D10_BNB_NODES);
   D10LpSol lp;
-  if (!d10SolveLpRelax(p, &lp) || !lp.feasible) return;
+  STAT_TIMER_START(D10_LP_RELAX);
+  int solved = d10SolveLpRelax(p, &lp);
+  STAT_TIMER_STOP(D10_LP_RELAX);
+  if (!solved || !lp.feasible) return;
   if (lp.sumX >= *best - 1e-9) return;
 
   int frac = -1;
@@ -489,6 +499,7 @@ static int solveMachinePart2Fast(const Machine10 *m) {
 }
 
 unsigned long long day10SolvePartTwo(const char *data) {
+  Arena *scratch = arenaScratch();
   unsigned long long total = 0;
   const char *p = data;
   while (*p) {
@@ -499,7 +510,8 @@ unsigned long long day10SolvePartTwo(const char *data) {
       if (*p == '\n') p++;
       continue;
     }
-    char *line = malloc(len + 1);
+    ArenaMark mark = arenaMark(scratch);
+    char *line = arenaAlloc(scratch, len + 1);
     if (!line) return total;
     memcpy(line, start, len);
     line[len] = '\0';
@@ -510,7 +522,7 @@ unsigned long long day10SolvePartTwo(const char *data) {
       if (best >= 0) total += (unsigned long long)best;
     }
 
-    free(line);
+    arenaRelease(scratch, mark);
     if (*p == '\n') p++;
   }
   return total;
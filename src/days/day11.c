@@ -1,339 +1,599 @@
 #include "days/day11.h"
 
+#include "stats.h"
+#include "tools.h"
+#include "validate.h"
+
 #include <stdint.h>
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+enum {
+  // Every three-letter lowercase name gets its own slot; anything else goes
+  // through the hash table.
+  D11_DIRECT_NAMES = 26 * 26 * 26,
+  D11_TABLE_CACHE_BYTES = 64 << 20
+};
+
+// Compact adjacency: the out-edges of u are adj[off[u] .. off[u + 1]).
+typedef struct {
+  int *off;
+  int *adj;
+} Csr11;
+
+// Node names point into the input text; nothing is copied.
 typedef struct {
+  const char *start;
+  int len;
+} Name11;
+
+// A cached reverse-topological DP table: paths[u] is the number of paths
+// from u to target, valid for every u ranked at or before target.
+typedef struct {
+  int target;
+  unsigned long long *paths;
+} PathTable;
+
+struct Day11Graph {
   int n;
-  int cap;
-  char **names;
-  int *head;
   int edges;
-  int edgeCap;
-  int *to;
-  int *next;
-  int mapCap;
-  int *mapId;
-} Graph11;
-
-static void graphInit(Graph11 *g) {
-  g->n = 0;
-  g->cap = 128;
-  g->names = (char **)calloc((size_t)g->cap, sizeof(char *));
-  g->head = (int *)malloc((size_t)g->cap * sizeof(int));
-  for (int i = 0; i < g->cap; ++i) g->head[i] = -1;
-  g->edges = 0;
-  g->edgeCap = 256;
-  g->to = (int *)malloc((size_t)g->edgeCap * sizeof(int));
-  g->next = (int *)malloc((size_t)g->edgeCap * sizeof(int));
-  g->mapCap = 256;
-  g->mapId = (int *)malloc((size_t)g->mapCap * sizeof(int));
-  for (int i = 0; i < g->mapCap; ++i) g->mapId[i] = -1;
-}
+  Name11 *names;
+  int *direct;
+  int *hashIds;
+  size_t hashMask;
+  Csr11 fwd;
+  Csr11 rev;
+  // Where the graph and its lazily built tables live: `own`, inside which
+  // the graph itself is allocated.
+  Arena *arena;
+  Arena own;
 
-static void graphDestroy(Graph11 *g) {
-  for (int i = 0; i < g->n; ++i) free(g->names[i]);
-  free(g->names);
-  free(g->head);
-  free(g->to);
-  free(g->next);
-  free(g->mapId);
-}
+  // Whole-graph topological order for repeated queries, built on first use:
+  // orderState is 0 before that, 1 for a DAG and -1 if the graph has a cycle.
+  int orderState;
+  int *order;
+  int *rank;
+  // Per-target tables; tableOf[t] is t's slot or -1. Slots are reused
+  // round-robin once D11_TABLE_CACHE_BYTES worth of tables exist.
+  PathTable *tables;
+  int *tableOf;
+  size_t tableCap;
+  size_t tableCount;
+  size_t nextEvict;
+};
 
-static int graphEnsureNodes(Graph11 *g, int need) {
-  if (need <= g->cap) return 1;
-  int newCap = g->cap;
-  while (newCap < need) newCap *= 2;
-  char **newNames = (char **)realloc(g->names, (size_t)newCap * sizeof(char *));
-  int *newHead = (int *)realloc(g->head, (size_t)newCap * sizeof(int));
-  if (!newNames || !newHead) return 0;
-  for (int i = g->cap; i < newCap; ++i) {
-    newHead[i] = -1;
-    newNames[i] = NULL;
-  }
-  g->names = newNames;
-  g->head = newHead;
-  g->cap = newCap;
-  return 1;
-}
+typedef struct {
+  size_t tokens;
+  size_t edges;
+  size_t otherNames;
+} GraphCounts;
 
-static int graphEnsureEdges(Graph11 *g, int need) {
-  if (need <= g->edgeCap) return 1;
-  int newCap = g->edgeCap;
-  while (newCap < need) newCap *= 2;
-  int *newTo = (int *)realloc(g->to, (size_t)newCap * sizeof(int));
-  int *newNext = (int *)realloc(g->next, (size_t)newCap * sizeof(int));
-  if (!newTo || !newNext) return 0;
-  g->to = newTo;
-  g->next = newNext;
-  g->edgeCap = newCap;
-  return 1;
+static int directIndex(const char *s, int len) {
+  if (len != 3) return -1;
+  unsigned a = (unsigned)(s[0] - 'a'), b = (unsigned)(s[1] - 'a'),
+           c = (unsigned)(s[2] - 'a');
+  if (a >= 26u || b >= 26u || c >= 26u) return -1;
+  return (int)((a * 26u + b) * 26u + c);
 }
 
-static unsigned long hashName(const char *s) {
-  unsigned long h = 5381UL;
-  while (*s) h = ((h << 5) + h) ^ (unsigned char)(*s++);
+static size_t hashName(const char *s, int len) {
+  size_t h = 5381u;
+  for (int i = 0; i < len; ++i) h = ((h << 5) + h) ^ (unsigned char)s[i];
   return h;
 }
 
-static int graphRehash(Graph11 *g) {
-  int newCap = g->mapCap * 2;
-  int *newMap = (int *)malloc((size_t)newCap * sizeof(int));
-  if (!newMap) return 0;
-  for (int i = 0; i < newCap; ++i) newMap[i] = -1;
-  int mask = newCap - 1;
-  for (int id = 0; id < g->n; ++id) {
-    unsigned long h = hashName(g->names[id]);
-    int pos = (int)(h & (unsigned long)mask);
-    while (newMap[pos] != -1) pos = (pos + 1) & mask;
-    newMap[pos] = id;
-  }
-  free(g->mapId);
-  g->mapId = newMap;
-  g->mapCap = newCap;
-  return 1;
+// Slot holding the id for a name, or the empty (-1) slot it would go into.
+static int *nameSlot(const Day11Graph *g, const char *s, int len) {
+  int direct = directIndex(s, len);
+  if (direct >= 0) return &g->direct[direct];
+  size_t pos = hashName(s, len) & g->hashMask;
+  for (;;) {
+    int id = g->hashIds[pos];
+    if (id < 0) return &g->hashIds[pos];
+    const Name11 *name = &g->names[id];
+    if (name->len == len && memcmp(name->start, s, (size_t)len) == 0) {
+      return &g->hashIds[pos];
+    }
+    pos = (pos + 1) & g->hashMask;
+  }
 }
 
-static int graphFind(Graph11 *g, const char *name) {
-  unsigned long h = hashName(name);
-  int mask = g->mapCap - 1;
-  int pos = (int)(h & (unsigned long)mask);
-  for (int step = 0; step < g->mapCap; ++step) {
-    int id = g->mapId[pos];
-    if (id == -1) return -1;
-    if (strcmp(g->names[id], name) == 0) return id;
-    pos = (pos + 1) & mask;
-  }
-  return -1;
+static int graphIntern(Day11Graph *g, const char *s, int len) {
+  int *slot = nameSlot(g, s, len);
+  if (*slot < 0) {
+    g->names[g->n] = (Name11){s, len};
+    *slot = g->n++;
+  }
+  return *slot;
 }
 
-static int graphAddNode(Graph11 *g, const char *name) {
-  int id = graphFind(g, name);
-  if (id >= 0) return id;
-  if (g->n * 2 >= g->mapCap) {
-    if (!graphRehash(g)) return -1;
-  }
-  if (!graphEnsureNodes(g, g->n + 1)) return -1;
-  size_t len = strlen(name);
-  char *copy = (char *)malloc(len + 1);
-  if (!copy) return -1;
-  memcpy(copy, name, len + 1);
-  if (!copy) return -1;
-  id = g->n++;
-  g->names[id] = copy;
-  g->head[id] = -1;
-  unsigned long h = hashName(name);
-  int mask = g->mapCap - 1;
-  int pos = (int)(h & (unsigned long)mask);
-  while (g->mapId[pos] != -1) pos = (pos + 1) & mask;
-  g->mapId[pos] = id;
-  return id;
+static int graphFind(const Day11Graph *g, const char *name) {
+  return *nameSlot(g, name, (int)strlen(name));
 }
 
-static int graphAddEdge(Graph11 *g, int from, int to) {
-  if (from < 0 || to < 0) return 0;
-  if (!graphEnsureEdges(g, g->edges + 1)) return 0;
-  int e = g->edges++;
-  g->to[e] = to;
-  g->next[e] = g->head[from];
-  g->head[from] = e;
-  return 1;
+static int isSpace(char c) { return c == ' ' || c == '\t'; }
+
+static void countToken(GraphCounts *counts, const char *s, int len) {
+  counts->tokens++;
+  if (directIndex(s, len) < 0) counts->otherNames++;
 }
 
-static unsigned long long dfsCount(int u, int target, const Graph11 *g,
-                                   unsigned long long *memo, uint8_t *state) {
-  if (state[u] == 2) return memo[u];
-  if (state[u] == 1) return 0;  // cycle detected: ignore
-  state[u] = 1;
-  unsigned long long ways = (u == target) ? 1ULL : 0ULL;
-  for (int e = g->head[u]; e != -1; e = g->next[e]) {
-    ways += dfsCount(g->to[e], target, g, memo, state);
-  }
-  state[u] = 2;
-  memo[u] = ways;
-  return ways;
+static int isNameChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
 }
 
-static unsigned long long solvePaths(const char *data) {
-  Graph11 g;
-  graphInit(&g);
+// Strict form of a non-empty line: an alphabetic name, ':', then at least
+// one alphabetic neighbor, separated by blanks.
+static int checkLine(const char *line, const char *colon,
+                     const char *lineEnd, const ParseError *err) {
+  if (!colon || colon == line) {
+    return parseFail(err,
+                     "Day 11 lines must look like 'node: neighbor neighbor'.");
+  }
+  for (const char *q = line; q < colon; ++q) {
+    if (!isNameChar(*q)) {
+      return parseFail(err, "Day 11 node names must be alphabetic tokens.");
+    }
+  }
+  int neighbors = 0;
+  for (const char *q = colon + 1; q < lineEnd; ++q) {
+    if (isSpace(*q)) continue;
+    if (!isNameChar(*q)) {
+      return parseFail(err,
+                       "Day 11 neighbor names must be alphabetic tokens.");
+    }
+    neighbors += q == colon + 1 || isSpace(q[-1]);
+  }
+  if (neighbors == 0) {
+    return parseFail(err,
+                     "Day 11 lines need at least one neighbor after ':'.");
+  }
+  return 1;
+}
 
+// One pass over "name: neighbor neighbor" lines. Without a graph it only
+// counts tokens and edges, and with err it also rejects the first malformed
+// line (returning 0); with a graph it interns the names and records every
+// edge as a (from, to) pair.
+static int scanLines(const char *data, GraphCounts *counts, Day11Graph *g,
+                     int *edgeFrom, int *edgeTo, const ParseError *err) {
   const char *p = data;
   while (*p) {
-    const char *lineStart = p;
+    const char *line = p;
     while (*p && *p != '\n') p++;
-    size_t len = (size_t)(p - lineStart);
-    if (len > 0) {
-      char *line = (char *)malloc(len + 1);
-      if (!line) {
-        graphDestroy(&g);
-        return 0;
-      }
-      memcpy(line, lineStart, len);
-      line[len] = '\0';
-
-      char *colon = strchr(line, ':');
-      if (colon) {
-        *colon = '\0';
-        char *lhs = line;
-        while (*lhs == ' ' || *lhs == '\t') lhs++;
-        char *end = lhs + strlen(lhs);
-        while (end > lhs && (end[-1] == ' ' || end[-1] == '\t')) *--end = '\0';
-        int fromId = graphAddNode(&g, lhs);
-
-        char *rhs = colon + 1;
-        while (*rhs) {
-          while (*rhs == ' ' || *rhs == '\t') rhs++;
-          if (*rhs == '\0') break;
-          char *tok = rhs;
-          while (*rhs && *rhs != ' ' && *rhs != '\t') rhs++;
-          char saved = *rhs;
-          *rhs = '\0';
-          int toId = graphAddNode(&g, tok);
-          graphAddEdge(&g, fromId, toId);
-          *rhs = saved;
-        }
+    const char *lineEnd = p;
+    if (*p == '\n') p++;
+
+    const char *colon = memchr(line, ':', (size_t)(lineEnd - line));
+    if (err && lineEnd > line && !checkLine(line, colon, lineEnd, err)) {
+      return 0;
+    }
+    if (!colon) continue;
+    const char *lhs = line;
+    const char *lhsEnd = colon;
+    while (lhs < lhsEnd && isSpace(*lhs)) lhs++;
+    while (lhsEnd > lhs && isSpace(lhsEnd[-1])) lhsEnd--;
+    int fromId = -1;
+    if (g) {
+      fromId = graphIntern(g, lhs, (int)(lhsEnd - lhs));
+    } else {
+      countToken(counts, lhs, (int)(lhsEnd - lhs));
+    }
+
+    const char *q = colon + 1;
+    while (q < lineEnd) {
+      while (q < lineEnd && isSpace(*q)) q++;
+      if (q >= lineEnd) break;
+      const char *tok = q;
+      while (q < lineEnd && !isSpace(*q)) q++;
+      int len = (int)(q - tok);
+      if (g) {
+        edgeFrom[g->edges] = fromId;
+        edgeTo[g->edges] = graphIntern(g, tok, len);
+        g->edges++;
+      } else {
+        countToken(counts, tok, len);
+        counts->edges++;
       }
-      free(line);
     }
-    if (*p == '\n') p++;
   }
+  if (err && counts->edges == 0) {
+    return parseFail(err, "Day 11 input lists no edges.");
+  }
+  return 1;
+}
+
+// Counting sort of the edge pairs into CSR form keyed on keys[].
+static void csrFill(const Day11Graph *g, const int *keys, const int *values,
+                    Csr11 *c) {
+  memset(c->off, 0, ((size_t)g->n + 1) * sizeof(int));
+  for (int e = 0; e < g->edges; ++e) c->off[keys[e] + 1]++;
+  for (int u = 0; u < g->n; ++u) c->off[u + 1] += c->off[u];
+  // Use the tail of off[] as the running cursor, then shift it back.
+  for (int e = 0; e < g->edges; ++e) c->adj[c->off[keys[e]]++] = values[e];
+  for (int u = g->n; u > 0; --u) c->off[u] = c->off[u - 1];
+  c->off[0] = 0;
+}
 
-  int youId = graphFind(&g, "you");
-  int outId = graphFind(&g, "out");
-  if (youId < 0 || outId < 0) {
-    graphDestroy(&g);
+// Two passes over the text: the first counts tokens and edges so every array
+// is allocated once at its final size; the second interns names (direct
+// index for three-letter lowercase names, hashing otherwise) and records the
+// edges, which are then counting-sorted into forward and reverse CSR arrays.
+// g must be zeroed apart from its arena. With err the first pass checks the
+// input strictly; 0 is returned for malformed input (with err filled in) as
+// well as for running out of memory.
+static int graphBuild(Day11Graph *g, const char *data, const ParseError *err) {
+  GraphCounts counts = {0, 0, 0};
+  if (!scanLines(data, &counts, NULL, NULL, NULL, err)) {
     return 0;
   }
 
-  unsigned long long *memo =
-      (unsigned long long *)calloc((size_t)g.n, sizeof(unsigned long long));
-  uint8_t *state = (uint8_t *)calloc((size_t)g.n, sizeof(uint8_t));
-  if (!memo || !state) {
-    free(memo);
-    free(state);
-    graphDestroy(&g);
+  size_t hashCap = 2;
+  while (hashCap < counts.otherNames * 2) hashCap *= 2;
+  size_t nodes = counts.tokens;
+  size_t edges = counts.edges;
+
+  Arena *arena = g->arena;
+  g->direct = arenaAlloc(arena, D11_DIRECT_NAMES * sizeof(int));
+  g->hashIds = arenaAlloc(arena, hashCap * sizeof(int));
+  g->hashMask = hashCap - 1;
+  g->names = arenaAlloc(arena, nodes * sizeof(Name11));
+  g->fwd.off = arenaAlloc(arena, (nodes + 1) * sizeof(int));
+  g->fwd.adj = arenaAlloc(arena, edges * sizeof(int));
+  g->rev.off = arenaAlloc(arena, (nodes + 1) * sizeof(int));
+  g->rev.adj = arenaAlloc(arena, edges * sizeof(int));
+  // The edge pairs are only needed until the CSR arrays are filled.
+  ArenaMark mark = arenaMark(arena);
+  int *edgeFrom = arenaAlloc(arena, edges * sizeof(int));
+  int *edgeTo = arenaAlloc(arena, edges * sizeof(int));
+  if (!g->direct || !g->hashIds || !g->names || !g->fwd.off || !g->fwd.adj ||
+      !g->rev.off || !g->rev.adj || !edgeFrom || !edgeTo) {
     return 0;
   }
-  unsigned long long ans = dfsCount(youId, outId, &g, memo, state);
-  free(memo);
-  free(state);
-  graphDestroy(&g);
-  return ans;
+  memset(g->direct, 0xFF, D11_DIRECT_NAMES * sizeof(int));
+  memset(g->hashIds, 0xFF, hashCap * sizeof(int));
+
+  scanLines(data, NULL, g, edgeFrom, edgeTo, NULL);
+  csrFill(g, edgeFrom, edgeTo, &g->fwd);
+  csrFill(g, edgeTo, edgeFrom, &g->rev);
+  arenaRelease(arena, mark);
+  return 1;
+}
+
+static void markReachable(const Csr11 *c, int root, uint8_t *mark, uint8_t bit,
+                          int *queue) {
+  int head = 0, tail = 0;
+  mark[root] |= bit;
+  queue[tail++] = root;
+  while (head < tail) {
+    int u = queue[head++];
+    for (int i = c->off[u]; i < c->off[u + 1]; ++i) {
+      int v = c->adj[i];
+      if (!(mark[v] & bit)) {
+        mark[v] |= bit;
+        queue[tail++] = v;
+      }
+    }
+  }
+}
+
+// Counts src -> dst paths within the nodes marked relevant, visiting the
+// topological positions [from, to] of order[] only.
+static unsigned long long segmentPaths(const Csr11 *fwd, const uint8_t *mark,
+                                       const int *order, const int *rank,
+                                       int from, int to,
+                                       unsigned long long *ways) {
+  for (int k = from; k <= to; ++k) ways[order[k]] = 0;
+  ways[order[from]] = 1;
+  for (int k = from; k < to; ++k) {
+    int u = order[k];
+    unsigned long long w = ways[u];
+    if (w == 0) continue;
+    for (int i = fwd->off[u]; i < fwd->off[u + 1]; ++i) {
+      int v = fwd->adj[i];
+      if (mark[v] == 3u && rank[v] <= to) ways[v] += w;
+    }
+  }
+  return ways[order[to]];
 }
 
-unsigned long long day11Solve(const char *data) { return solvePaths(data); }
-
-// Part 2: count paths from svr to out that visit both dac and fft (any order).
-
-static unsigned long long dfsCountMask(int u, int target, const Graph11 *g,
-                                       const uint8_t *reqBits, uint8_t reqMask,
-                                       unsigned long long *memo, uint8_t *state,
-                                       uint8_t mask) {
-  size_t idx = ((size_t)u << 2) | mask;
-  if (state[idx] == 2) return memo[idx];
-  if (state[idx] == 1) return 0;
-  uint8_t newMask = (uint8_t)(mask | reqBits[u]);
-  if (u == target) {
-    unsigned long long ok = ((newMask & reqMask) == reqMask) ? 1ULL : 0ULL;
-    state[idx] = 2;
-    memo[idx] = ok;
-    return ok;
-  }
-  state[idx] = 1;
-  unsigned long long ways = 0;
-  for (int e = g->head[u]; e != -1; e = g->next[e]) {
-    ways += dfsCountMask(g->to[e], target, g, reqBits, reqMask, memo, state,
-                         newMask);
-  }
-  state[idx] = 2;
-  memo[idx] = ways;
-  return ways;
+static int compareInt(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
 }
 
-unsigned long long day11SolvePartTwo(const char *data) {
-  Graph11 g;
-  graphInit(&g);
+// Counts src -> dst paths that visit every node in via[]. Only nodes on some
+// src -> dst path matter; they are put in topological order with Kahn's
+// algorithm, and a cycle among them (infinitely many paths) is reported
+// instead of counted. In a DAG every path meets the waypoints in
+// topological order, so of all waypoint orderings only the sorted one can
+// contribute: the count is the product of the segment counts
+// src -> w1 -> ... -> wk -> dst. The segments cover disjoint ranges of the
+// order, so all of them together cost one pass over the relevant graph.
+static Day11Status countPaths(const Day11Graph *g, int src, int dst,
+                              const int *via, int viaCount,
+                              unsigned long long *out) {
+  size_t n = (size_t)g->n;
+  size_t stops = (size_t)viaCount + 2;
+  const Csr11 *fwd = &g->fwd;
+  Arena *scratch = arenaScratch();
+  ArenaMark frame = arenaMark(scratch);
+  uint8_t *mark = arenaAllocZero(scratch, n, sizeof(uint8_t));
+  int *queue = arenaAlloc(scratch, n * sizeof(int));
+  int *indeg = arenaAllocZero(scratch, n, sizeof(int));
+  int *ranks = arenaAlloc(scratch, stops * sizeof(int));
+  unsigned long long *ways =
+      arenaAlloc(scratch, n * sizeof(unsigned long long));
+  if (!mark || !queue || !indeg || !ranks || !ways) {
+    arenaRelease(scratch, frame);
+    return Day11OutOfMemory;
+  }
 
-  const char *p = data;
-  while (*p) {
-    const char *lineStart = p;
-    while (*p && *p != '\n') p++;
-    size_t len = (size_t)(p - lineStart);
-    if (len > 0) {
-      char *line = (char *)malloc(len + 1);
-      if (!line) {
-        graphDestroy(&g);
-        return 0;
-      }
-      memcpy(line, lineStart, len);
-      line[len] = '\0';
-
-      char *colon = strchr(line, ':');
-      if (colon) {
-        *colon = '\0';
-        char *lhs = line;
-        while (*lhs == ' ' || *lhs == '\t') lhs++;
-        char *end = lhs + strlen(lhs);
-        while (end > lhs && (end[-1] == ' ' || end[-1] == '\t')) *--end = '\0';
-        int fromId = graphAddNode(&g, lhs);
-
-        char *rhs = colon + 1;
-        while (*rhs) {
-          while (*rhs == ' ' || *rhs == '\t') rhs++;
-          if (*rhs == '\0') break;
-          char *tok = rhs;
-          while (*rhs && *rhs != ' ' && *rhs != '\t') rhs++;
-          char saved = *rhs;
-          *rhs = '\0';
-          int toId = graphAddNode(&g, tok);
-          graphAddEdge(&g, fromId, toId);
-          *rhs = saved;
-        }
-      }
-      free(line);
+  markReachable(fwd, src, mark, 1u, queue);
+  markReachable(&g->rev, dst, mark, 2u, queue);
+
+  size_t relevant = 0;
+  for (size_t u = 0; u < n; ++u) {
+    if (mark[u] != 3u) continue;
+    relevant++;
+    for (int i = fwd->off[u]; i < fwd->off[u + 1]; ++i) {
+      if (mark[fwd->adj[i]] == 3u) indeg[fwd->adj[i]]++;
     }
-    if (*p == '\n') p++;
   }
 
-  int start = graphFind(&g, "svr");
-  int target = graphFind(&g, "out");
-  int dacId = graphFind(&g, "dac");
-  int fftId = graphFind(&g, "fft");
-  if (start < 0 || target < 0 || dacId < 0 || fftId < 0) {
-    graphDestroy(&g);
-    return 0;
+  Day11Status status = Day11Ok;
+  *out = 0;
+  if (relevant == 0) goto done;
+  for (int k = 0; k < viaCount; ++k) {
+    if (mark[via[k]] != 3u) goto done;
   }
 
-  uint8_t reqMask = 3u;
-  uint8_t *reqBits = (uint8_t *)calloc((size_t)g.n, sizeof(uint8_t));
-  if (!reqBits) {
-    graphDestroy(&g);
-    return 0;
+  size_t head = 0, tail = 0;
+  for (size_t u = 0; u < n; ++u) {
+    if (mark[u] == 3u && indeg[u] == 0) queue[tail++] = (int)u;
   }
-  reqBits[dacId] |= 1u;
-  reqBits[fftId] |= 2u;
-
-  size_t states = (size_t)g.n * 4u;
-  unsigned long long *memo =
-      (unsigned long long *)calloc(states, sizeof(unsigned long long));
-  uint8_t *state = (uint8_t *)calloc(states, sizeof(uint8_t));
-  if (!memo || !state) {
-    free(memo);
-    free(state);
-    free(reqBits);
-    graphDestroy(&g);
-    return 0;
+  while (head < tail) {
+    int u = queue[head++];
+    for (int i = fwd->off[u]; i < fwd->off[u + 1]; ++i) {
+      int v = fwd->adj[i];
+      if (mark[v] == 3u && --indeg[v] == 0) queue[tail++] = v;
+    }
+  }
+  if (tail < relevant) {
+    status = Day11Cycle;
+    goto done;
   }
 
-  unsigned long long ans =
-      dfsCountMask(start, target, &g, reqBits, reqMask, memo, state, 0);
+  // queue[] now holds the topological order; indeg[] is free to hold ranks.
+  int *rank = indeg;
+  for (size_t k = 0; k < relevant; ++k) rank[queue[k]] = (int)k;
 
-  free(memo);
-  free(state);
-  free(reqBits);
-  graphDestroy(&g);
-  return ans;
+  // src and dst are the first and last relevant nodes, so sorting the
+  // waypoint ranks between them gives the only viable visiting order.
+  for (int k = 0; k < viaCount; ++k) ranks[k] = rank[via[k]];
+  qsort(ranks, (size_t)viaCount, sizeof(int), compareInt);
+  unsigned long long total = 1;
+  int from = rank[src];
+  for (size_t k = 0; k <= (size_t)viaCount && total != 0; ++k) {
+    int to = k < (size_t)viaCount ? ranks[k] : rank[dst];
+    if (to == from) continue;
+    total *= segmentPaths(fwd, mark, queue, rank, from, to, ways);
+    from = to;
+  }
+  *out = total;
+
+done:
+  arenaRelease(scratch, frame);
+  return status;
+}
+
+// Looks up the query names; returns 0 when any of them is not in the graph,
+// which simply means there are no such paths.
+static int resolveQuery(const Day11Graph *g, const char *srcName,
+                        const char *dstName, const char *const *viaNames,
+                        int viaCount, int *src, int *dst, int *via) {
+  *src = graphFind(g, srcName);
+  *dst = graphFind(g, dstName);
+  int ok = *src >= 0 && *dst >= 0;
+  for (int k = 0; ok && k < viaCount; ++k) {
+    via[k] = graphFind(g, viaNames[k]);
+    ok = via[k] >= 0;
+  }
+  return ok;
+}
+
+static Day11Graph *graphCreate(const char *data, const ParseError *err) {
+  Arena own = arenaCreate(sizeof(Day11Graph));
+  Day11Graph *g = arenaAllocZero(&own, 1, sizeof(*g));
+  if (!g) {
+    arenaDestroy(&own);
+    return NULL;
+  }
+  g->own = own;
+  g->arena = &g->own;
+  if (!graphBuild(g, data, err)) {
+    day11GraphDestroy(g);
+    return NULL;
+  }
+  return g;
+}
+
+Day11Graph *day11GraphCreateStrict(const char *data, size_t size,
+                                   char *errBuf, size_t errBufSize) {
+  const ParseError err = {errBuf, errBufSize};
+  if (errBufSize > 0) {
+    errBuf[0] = '\0';
+  }
+  if (size == 0) {
+    parseFail(&err, "Day 11 input is empty.");
+    return NULL;
+  }
+  return graphCreate(data, &err);
+}
+
+int day11Validate(const char *data, size_t size, char *errBuf,
+                  size_t errBufSize) {
+  const ParseError err = {errBuf, errBufSize};
+  if (size == 0) {
+    return parseFail(&err, "Day 11 input is empty.");
+  }
+  GraphCounts counts = {0, 0, 0};
+  return scanLines(data, &counts, NULL, NULL, NULL, &err);
+}
+
+void day11GraphDestroy(Day11Graph *g) {
+  if (!g) return;
+  // The graph sits inside its own arena; tear it down from a copy.
+  Arena own = g->own;
+  arenaDestroy(&own);
+}
+
+// Kahn's algorithm over the whole graph, once per graph.
+static int graphOrder(Day11Graph *g) {
+  if (g->orderState != 0) return 1;
+  size_t n = (size_t)g->n;
+  g->order = arenaAlloc(g->arena, (n + 1) * sizeof(int));
+  g->rank = arenaAllocZero(g->arena, n + 1, sizeof(int));
+  if (!g->order || !g->rank) return 0;
+
+  int *indeg = g->rank;
+  for (int e = 0; e < g->edges; ++e) indeg[g->fwd.adj[e]]++;
+  size_t head = 0, tail = 0;
+  for (size_t u = 0; u < n; ++u) {
+    if (indeg[u] == 0) g->order[tail++] = (int)u;
+  }
+  while (head < tail) {
+    int u = g->order[head++];
+    for (int i = g->fwd.off[u]; i < g->fwd.off[u + 1]; ++i) {
+      int v = g->fwd.adj[i];
+      if (--indeg[v] == 0) g->order[tail++] = v;
+    }
+  }
+  if (tail < n) {
+    g->orderState = -1;
+    return 1;
+  }
+  for (size_t k = 0; k < n; ++k) g->rank[g->order[k]] = (int)k;
+  g->orderState = 1;
+  return 1;
+}
+
+// Path counts into target from every node ranked before it, swept in reverse
+// topological order and cached per target.
+static const unsigned long long *pathsTo(Day11Graph *g, int target) {
+  size_t n = (size_t)g->n;
+  if (!g->tables) {
+    size_t cap = D11_TABLE_CACHE_BYTES / (n * sizeof(unsigned long long) + 1);
+    g->tableCap = cap > 0 ? cap : 1;
+    g->tables = arenaAllocZero(g->arena, g->tableCap, sizeof(PathTable));
+    g->tableOf = arenaAlloc(g->arena, n * sizeof(int));
+    if (!g->tables || !g->tableOf) return NULL;
+    memset(g->tableOf, 0xFF, n * sizeof(int));
+  }
+  if (g->tableOf[target] >= 0) {
+    STAT_INC(D11_TABLE_HITS);
+    return g->tables[g->tableOf[target]].paths;
+  }
+  STAT_INC(D11_TABLE_BUILDS);
+
+  size_t slot;
+  if (g->tableCount < g->tableCap) {
+    slot = g->tableCount;
+    g->tables[slot].paths =
+        arenaAlloc(g->arena, n * sizeof(unsigned long long));
+    if (!g->tables[slot].paths) return NULL;
+    g->tableCount++;
+  } else {
+    slot = g->nextEvict;
+    g->nextEvict = (g->nextEvict + 1) % g->tableCap;
+    g->tableOf[g->tables[slot].target] = -1;
+  }
+  PathTable *table = &g->tables[slot];
+  table->target = target;
+  g->tableOf[target] = (int)slot;
+
+  unsigned long long *paths = table->paths;
+  int last = g->rank[target];
+  paths[target] = 1;
+  for (int k = last - 1; k >= 0; --k) {
+    int u = g->order[k];
+    unsigned long long ways = 0;
+    for (int i = g->fwd.off[u]; i < g->fwd.off[u + 1]; ++i) {
+      int v = g->fwd.adj[i];
+      if (g->rank[v] <= last) ways += paths[v];
+    }
+    paths[u] = ways;
+  }
+  return paths;
+}
+
+Day11Status day11GraphCountPaths(Day11Graph *g, const char *srcName,
+                                 const char *dstName,
+                                 const char *const *viaNames, int viaCount,
+                                 unsigned long long *out) {
+  *out = 0;
+  if (viaCount < 0) viaCount = 0;
+  if (!graphOrder(g)) return Day11OutOfMemory;
+
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  int src, dst;
+  Day11Status status = Day11Ok;
+  int *via = arenaAllocZero(scratch, (size_t)viaCount + 1, sizeof(int));
+  if (!via) {
+    status = Day11OutOfMemory;
+    goto done;
+  }
+  if (!resolveQuery(g, srcName, dstName, viaNames, viaCount, &src, &dst,
+                    via)) {
+    goto done;
+  }
+  if (g->orderState < 0) {
+    // Cycles somewhere: only those on a src -> dst path matter, which the
+    // per-query engine checks on the relevant subgraph.
+    status = countPaths(g, src, dst, via, viaCount, out);
+    goto done;
+  }
+
+  // Every path visits nodes in increasing rank, so the waypoints must lie
+  // between src and dst and are visited in rank order.
+  for (int k = 0; k < viaCount; ++k) {
+    int r = g->rank[via[k]];
+    if (r < g->rank[src] || r > g->rank[dst]) goto done;
+    via[k] = r;
+  }
+  qsort(via, (size_t)viaCount, sizeof(int), compareInt);
+  if (g->rank[src] > g->rank[dst]) goto done;
+
+  unsigned long long total = 1;
+  int from = src;
+  for (int k = 0; k <= viaCount && total != 0; ++k) {
+    int to = k < viaCount ? g->order[via[k]] : dst;
+    if (to == from) continue;
+    const unsigned long long *paths = pathsTo(g, to);
+    if (!paths) {
+      status = Day11OutOfMemory;
+      goto done;
+    }
+    total *= paths[from];
+    from = to;
+  }
+  *out = total;
+
+done:
+  arenaRelease(scratch, mark);
+  return status;
+}
+
+const char *day11StatusMessage(Day11Status status) {
+  switch (status) {
+  case Day11Ok:
+    return "ok";
+  case Day11Cycle:
+    return "Day 11 graph has a cycle on a path to the target, so the path "
+           "count is infinite.";
+  case Day11OutOfMemory:
+    return "Day 11 ran out of memory.";
+  }
+  return "Day 11 failed.";
 }
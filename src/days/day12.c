@@ -1,8 +1,24 @@
+#define _DEFAULT_SOURCE
+
 #include "days/day12.h"
 
+#include "fastnum.h"
+#include "lines.h"
+#include "parallel.h"
+#include "stats.h"
+#include "tools.h"
+#include "validate.h"
+
+#include <limits.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 typedef struct {
   int cells;
@@ -20,17 +36,33 @@ typedef struct {
   int w, h;
   int counts[16];
   int nShapes;
-  int totalArea;
+  // Dimensions and counts go up to INT_MAX, so areas need 64 bits.
+  long long totalArea;
 } Region12;
 
 enum {
-  // Exact packing is NP-hard; we only run the exact solver for small regions
-  // (sample-sized). For larger regions in the real input, we rely on the
-  // fast necessary-and-sufficient checks used by this puzzle's data.
-  D12_EXACT_MAX_CELLS = 256,
-  D12_MAX_WORDS = (D12_EXACT_MAX_CELLS + 63) / 64
+  D12_MAX_SHAPES = 16,
+  // Slots in the per-region table of dead (frontier, occupancy window,
+  // remaining counts) states; once full the search goes on without new ones.
+  D12_MEMO_MAX_SLOTS = 1 << 20,
+  D12_MEMO_MIN_CAPACITY = 1 << 10,
+  D12_MIN_TABLE_SLOTS = 16,
+  // Alignment of bitboards and piece masks (one cache line).
+  D12_WORD_ALIGN = 64,
+  // Splitting one region's search: aim for this many subtrees per worker so
+  // uneven subtrees balance out, expanding at most this many decisions.
+  D12_SPLIT_TASKS_PER_THREAD = 8,
+  D12_SPLIT_MAX_DEPTH = 6,
+  // Largest region the exact search takes on; bigger ones the area and box
+  // checks cannot settle are left undecided, which also keeps every cell
+  // offset within int.
+  D12_MAX_SEARCH_CELLS = 1 << 24,
+  // Search nodes between checks of the clock and the cancel flag.
+  D12_CHECK_INTERVAL = 1 << 12
 };
 
+typedef enum { Fit12No, Fit12Yes, Fit12Undecided, Fit12Skipped } Fit12;
+
 static int minInt(int a, int b) { return a < b ? a : b; }
 static int maxInt(int a, int b) { return a > b ? a : b; }
 
@@ -80,7 +112,7 @@ static void buildOrientations(Shape12 *s, const char (*grid)[8], int h) {
   int cnt = 0;
   for (int y = 0; y < h; ++y) {
     for (int x = 0; grid[y][x]; ++x) {
-      if (grid[y][x] == '#') {
+      if (grid[y][x] == '#' && cnt < 16) {
         coords[cnt][0] = x;
         coords[cnt][1] = y;
         cnt++;
@@ -88,6 +120,9 @@ static void buildOrientations(Shape12 *s, const char (*grid)[8], int h) {
     }
   }
   s->area = cnt;
+  // An empty shape takes no room: no orientations, and regions drop its
+  // counts.
+  if (cnt == 0) return;
   // generate 8 transforms (4 rotations, with flip)
   for (int flip = 0; flip < 2; ++flip) {
     for (int rot = 0; rot < 4; ++rot) {
@@ -112,289 +147,1106 @@ static void buildOrientations(Shape12 *s, const char (*grid)[8], int h) {
   }
 }
 
-// Parse input
-static int parseInput(const char *data, Shape12 *shapes, int *shapeCount,
-                      Region12 **regionsOut, int *regionCount) {
-  // collect lines
-  const char *p = data;
-  char (*lines)[128] = NULL;
-  int cap = 64, cnt = 0;
-  lines = (char (*)[128])malloc((size_t)cap * 128);
-  if (!lines) return 0;
-  while (*p) {
-    if (cnt >= cap) {
-      cap *= 2;
-      char (*nl)[128] = (char (*)[128])realloc(lines, (size_t)cap * 128);
-      if (!nl) {
-        free(lines);
-        return 0;
+ARENA_VEC(RegionVec, Region12)
+
+static int onlyBlanks(const char *p, const char *end) {
+  for (; p < end; ++p) {
+    if (*p != ' ' && *p != '\t') return 0;
+  }
+  return 1;
+}
+
+static int parseCount(const char **p, const char *end, int *out) {
+  unsigned long long value;
+  if (!fastParseU64(p, end, &value) || value > INT_MAX) return 0;
+  *out = (int)value;
+  return 1;
+}
+
+// "WxH: c0 c1 ...". Returns 0 when the line is not a region; strict mode
+// also requires well-formed numbers and exactly one count per shape.
+static int parseRegion(const char *line, const char *end, int shapeCount,
+                       const ParseError *err, Region12 *r) {
+  const char *xpos = memchr(line, 'x', (size_t)(end - line));
+  const char *colon = memchr(line, ':', (size_t)(end - line));
+  if (!xpos || !colon || xpos > colon) {
+    return err ? parseFail(err, "Day 12 region lines must look like 'WxH: "
+                                "counts...'.")
+               : 0;
+  }
+  memset(r, 0, sizeof(*r));
+  r->nShapes = shapeCount;
+  const char *p = line;
+  int value = 0;
+  if (!parseCount(&p, xpos, &value) || p != xpos) {
+    if (err) return parseFail(err, "Day 12 region width is invalid.");
+    value = 0;
+  }
+  r->w = value;
+  p = xpos + 1;
+  value = 0;
+  if (!parseCount(&p, colon, &value) || p != colon) {
+    if (err) return parseFail(err, "Day 12 region height is invalid.");
+    value = 0;
+  }
+  r->h = value;
+  p = colon + 1;
+  int counts = 0;
+  for (;;) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p >= end) break;
+    int c = 0;
+    if (!parseCount(&p, end, &c) ||
+        (p < end && *p != ' ' && *p != '\t')) {
+      if (err) {
+        return parseFail(
+            err, "Day 12 region counts must be integers separated by spaces.");
       }
-      lines = nl;
-    }
-    int len = 0;
-    while (p[len] && p[len] != '\n' && len < 127) {
-      lines[cnt][len] = p[len];
-      len++;
+      while (p < end && *p != ' ' && *p != '\t') p++;
     }
-    lines[cnt][len] = '\0';
-    cnt++;
-    p += len;
-    if (*p == '\n') p++;
-    else if (!*p) break;
+    if (counts < shapeCount) r->counts[counts] = c;
+    counts++;
+  }
+  if (err && counts == 0) {
+    return parseFail(err, "Day 12 region line has no shape counts listed.");
   }
+  if (err && counts != shapeCount) {
+    return parseFail(
+        err, "Day 12 region count length must match number of shapes.");
+  }
+  return 1;
+}
 
-  int idx = 0;
+// Strict parsing (err != NULL) stops at the first malformed line with the
+// message validateInputForDay gives; lenient parsing skips what it cannot
+// read.
+static int parseInput(const char *data, size_t size, Arena *scratch,
+                      const ParseError *err, Shape12 *shapes,
+                      int *shapeCount, Region12 **regionsOut,
+                      int *regionCount) {
+  if (err && size == 0) {
+    return parseFail(err, "Day 12 input is empty.");
+  }
+  LineIndex index;
+  if (!lineIndexBuild(&index, data, size, scratch)) {
+    return err ? parseFail(err,
+                           "Allocation failure while validating Day 12 input.")
+               : 0;
+  }
+  const size_t cnt = index.count;
+  size_t idx = 0;
   int sCount = 0;
   // shapes
   while (idx < cnt) {
-    if (lines[idx][0] == '\0') {
+    const char *line = data + lineStart(&index, idx);
+    const size_t len = lineLength(&index, idx);
+    if (len == 0) {
       idx++;
       continue;
     }
-    char *colon = strchr(lines[idx], ':');
-    if (!colon) break;
-    int headerNum = atoi(lines[idx]);
-    if (headerNum != sCount) break;
+    // "5x3: ..." is a region even when its width matches the next shape index.
+    const char *colon = memchr(line, ':', len);
+    const char *xpos = memchr(line, 'x', len);
+    if (!colon || (xpos && (!err || xpos < colon))) break;
+    char header[16];
+    if (err && len >= sizeof(header)) {
+      return parseFail(err, "Day 12 shape header is too long.");
+    }
+    const size_t headerLen = len < sizeof(header) ? len : sizeof(header) - 1;
+    memcpy(header, line, headerLen);
+    header[headerLen] = '\0';
+    if (atoi(header) != sCount) {
+      if (err) {
+        return parseFail(err,
+                         "Day 12 shape IDs must start at 0 and increment.");
+      }
+      break;
+    }
+    if (err && !onlyBlanks(colon + 1, line + len)) {
+      return parseFail(
+          err, "Day 12 shape header should be just '<id>:' with no extras.");
+    }
+    if (err && sCount >= D12_MAX_SHAPES) {
+      return parseFail(err, "Day 12 input defines more than 16 shapes.");
+    }
     idx++;
     char shapeGrid[8][8] = {{0}};
     int h = 0;
-    while (idx < cnt && lines[idx][0] != '\0' &&
-           strchr(lines[idx], ':') == NULL && !strchr(lines[idx], 'x')) {
-      strncpy(shapeGrid[h], lines[idx], sizeof(shapeGrid[h]) - 1);
-      shapeGrid[h][sizeof(shapeGrid[h]) - 1] = '\0';
+    int cells = 0;
+    while (idx < cnt) {
+      const char *row = data + lineStart(&index, idx);
+      const size_t rowLen = lineLength(&index, idx);
+      if (rowLen == 0 || memchr(row, ':', rowLen) || memchr(row, 'x', rowLen))
+        break;
+      if (err) {
+        for (size_t i = 0; i < rowLen; ++i) {
+          if (row[i] != '.' && row[i] != '#') {
+            return parseFail(
+                err, "Day 12 shape rows must only contain '.' or '#'.");
+          }
+          cells += row[i] == '#';
+        }
+        if (h >= 8 || rowLen >= sizeof(shapeGrid[h]) || cells > 16) {
+          return parseFail(
+              err, "Day 12 shapes must fit 16 cells within 8 rows of 7.");
+        }
+      }
+      const size_t copy = rowLen < sizeof(shapeGrid[h]) - 1
+                              ? rowLen
+                              : sizeof(shapeGrid[h]) - 1;
+      memcpy(shapeGrid[h], row, copy);
       h++;
       idx++;
-      if (h >= 8) break;
+      if (h >= 8 && !err) break;
+    }
+    if (err && h == 0) {
+      return parseFail(err, "Day 12 shape definition has no rows.");
     }
     Shape12 *s = &shapes[sCount];
     memset(s, 0, sizeof(*s));
-    buildOrientations(s, shapeGrid, h);
+    buildOrientations(s, (const char (*)[8])shapeGrid, h);
     sCount++;
-    if (sCount >= 16) break;
+    if (sCount >= D12_MAX_SHAPES && !err) break;
   }
   *shapeCount = sCount;
+  if (err && sCount == 0) {
+    return parseFail(err, "Day 12 input defines no shapes.");
+  }
 
   // regions
-  int rCap = 8;
-  int rCount = 0;
-  Region12 *regs = (Region12 *)malloc((size_t)rCap * sizeof(Region12));
-  if (!regs) {
-    free(lines);
-    return 0;
-  }
+  RegionVec regs = {0};
   for (; idx < cnt; ++idx) {
-    if (lines[idx][0] == '\0') continue;
+    const char *line = data + lineStart(&index, idx);
+    const size_t len = lineLength(&index, idx);
+    if (len == 0) continue;
     Region12 r;
-    memset(&r, 0, sizeof(r));
-    char *xpos = strchr(lines[idx], 'x');
-    if (!xpos) continue;
-    *xpos = '\0';
-    r.w = atoi(lines[idx]);
-    r.h = atoi(xpos + 1);
-    r.nShapes = sCount;
-    char *counts = strchr(xpos + 1, ':');
-    if (!counts) continue;
-    counts++;
-    for (int i = 0; i < sCount; ++i) {
-      while (*counts == ' ') counts++;
-      r.counts[i] = atoi(counts);
-      while (*counts && *counts != ' ') counts++;
+    if (!parseRegion(line, line + len, sCount, err, &r)) {
+      if (err) return 0;
+      continue;
     }
     r.totalArea = 0;
-    for (int i = 0; i < sCount; ++i) r.totalArea += r.counts[i] * shapes[i].area;
-    if (rCount >= rCap) {
-      rCap *= 2;
-      Region12 *nr = (Region12 *)realloc(regs, (size_t)rCap * sizeof(Region12));
-      if (!nr) {
-        free(regs);
-        free(lines);
-        return 0;
-      }
-      regs = nr;
+    for (int i = 0; i < sCount; ++i) {
+      if (shapes[i].area == 0) r.counts[i] = 0;
+      r.totalArea += (long long)r.counts[i] * shapes[i].area;
+    }
+    if (!RegionVecPush(scratch, &regs, r)) {
+      return err ? parseFail(err,
+                             "Allocation failure while validating Day 12 "
+                             "input.")
+                 : 0;
     }
-    regs[rCount++] = r;
+  }
+  if (err && regs.count == 0) {
+    return parseFail(err, "Day 12 input lists no regions.");
   }
 
-  free(lines);
-  *regionsOut = regs;
-  *regionCount = rCount;
+  *regionsOut = regs.items;
+  *regionCount = (int)regs.count;
   return 1;
 }
 
+// One orientation of a shape, anchored at its first cell in row-major order.
+// mask holds the cells as bit offsets from the anchor (row stride = region
+// width), so every other cell lies after the anchor; rel lists the same
+// offsets. anchors marks the board cells this piece may be anchored at
+// without crossing an edge.
 typedef struct {
-  uint64_t bits[D12_MAX_WORDS];
-} Mask12;
+  int shape;
+  int anchorX;
+  int w, h;
+  int cells;
+  int rel[16];
+  const uint64_t *mask;
+  const uint64_t *anchors;
+} Piece12;
 
+// Lives in an arena of its own that is replaced whole when the table grows,
+// so a search holds only its current table however often it doubles.
 typedef struct {
-  Mask12 m;
-} Placement12;
+  uint64_t *keys;
+  size_t capacity;
+  size_t count;
+  Arena own;
+} DeadSet12;
 
-static int maskOverlaps(const uint64_t *occ, const Mask12 *m, int words) {
-  for (int i = 0; i < words; ++i) {
-    if (occ[i] & m->bits[i]) return 1;
+// Exact packing search. The first undecided cell (the frontier) is either
+// covered by a piece anchored there or, while the spare area allows it, left
+// empty; identical pieces are interchangeable because only per-shape counts
+// are tracked. Every occupied cell past the frontier lies within one piece
+// span of it, so (frontier, occupancy window, counts) fully describes a
+// state, and states proven dead are remembered.
+typedef struct {
+  int w, h, cells;
+  int spanWords;
+  int nShapes;
+  int counts[D12_MAX_SHAPES];
+  int remaining;
+  int slack;
+  const Piece12 *pieces;
+  const int *pieceStart;
+  uint64_t *occ;
+  uint64_t *key;
+  int keyWords;
+  // Coverage windows for the dead-cell check.
+  uint64_t *scratch;
+  DeadSet12 dead;
+  // Budget: once spent (or the run is cancelled) the search unwinds without
+  // recording dead states, since nothing was proven.
+  unsigned long long nodes;
+  unsigned long long nodeBudget;
+  // Split searches pool their nodes here; otherNodes is what the sibling
+  // tasks had spent at the last check.
+  atomic_ullong *sharedNodes;
+  unsigned long long otherNodes;
+  struct timespec deadline;
+  int hasDeadline;
+  atomic_int *cancel;
+  int aborted;
+} Packer12;
+
+static int budgetSpent(Packer12 *pk) {
+  pk->nodes++;
+  if (pk->nodeBudget && pk->nodes + pk->otherNodes > pk->nodeBudget) return 1;
+  if (pk->nodes % D12_CHECK_INTERVAL != 0) return 0;
+  if (pk->sharedNodes) {
+    pk->otherNodes = atomic_fetch_add(pk->sharedNodes, D12_CHECK_INTERVAL) +
+                     D12_CHECK_INTERVAL - pk->nodes;
+  }
+  if (pk->cancel && atomic_load(pk->cancel)) return 1;
+  if (!pk->hasDeadline) return 0;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec > pk->deadline.tv_sec ||
+         (now.tv_sec == pk->deadline.tv_sec &&
+          now.tv_nsec >= pk->deadline.tv_nsec);
+}
+
+// Masks spanning four or more words (regions over ~128 cells wide) go through
+// AVX2 four words at a time; shifting by 64 yields 0 there, so the word
+// carried into the next lane needs no special case.
+static int pieceOverlaps(const Packer12 *pk, int f, const uint64_t *mask) {
+  const uint64_t *occ = pk->occ + (f >> 6);
+  const int sh = f & 63;
+  int i = 0;
+#ifdef __AVX2__
+  const __m256i left = _mm256_set1_epi64x(sh);
+  const __m256i right = _mm256_set1_epi64x(64 - sh);
+  __m256i hits = _mm256_setzero_si256();
+  for (; i + 4 <= pk->spanWords; i += 4) {
+    __m256i m = _mm256_loadu_si256((const __m256i *)(mask + i));
+    __m256i lo = _mm256_and_si256(
+        _mm256_loadu_si256((const __m256i *)(occ + i)),
+        _mm256_sllv_epi64(m, left));
+    __m256i hi = _mm256_and_si256(
+        _mm256_loadu_si256((const __m256i *)(occ + i + 1)),
+        _mm256_srlv_epi64(m, right));
+    hits = _mm256_or_si256(hits, _mm256_or_si256(lo, hi));
+  }
+  if (!_mm256_testz_si256(hits, hits)) return 1;
+#endif
+  for (; i < pk->spanWords; ++i) {
+    uint64_t lo = mask[i] << sh;
+    uint64_t hi = sh ? mask[i] >> (64 - sh) : 0;
+    if ((occ[i] & lo) | (occ[i + 1] & hi)) return 1;
   }
   return 0;
 }
 
-static void maskXor(uint64_t *occ, const Mask12 *m, int words) {
-  for (int i = 0; i < words; ++i) occ[i] ^= m->bits[i];
+static void pieceToggle(Packer12 *pk, int f, const uint64_t *mask) {
+  uint64_t *occ = pk->occ + (f >> 6);
+  const int sh = f & 63;
+  int i = 0;
+#ifdef __AVX2__
+  const __m256i left = _mm256_set1_epi64x(sh);
+  const __m256i right = _mm256_set1_epi64x(64 - sh);
+  for (; i + 4 <= pk->spanWords; i += 4) {
+    __m256i m = _mm256_loadu_si256((const __m256i *)(mask + i));
+    __m256i *lo = (__m256i *)(occ + i);
+    _mm256_storeu_si256(lo, _mm256_xor_si256(_mm256_loadu_si256(lo),
+                                             _mm256_sllv_epi64(m, left)));
+    __m256i *hi = (__m256i *)(occ + i + 1);
+    _mm256_storeu_si256(hi, _mm256_xor_si256(_mm256_loadu_si256(hi),
+                                             _mm256_srlv_epi64(m, right)));
+  }
+#endif
+  for (; i < pk->spanWords; ++i) {
+    occ[i] ^= mask[i] << sh;
+    if (sh) occ[i + 1] ^= mask[i] >> (64 - sh);
+  }
 }
 
-static int allCountsZero(const int *counts, int n) {
-  for (int i = 0; i < n; ++i)
-    if (counts[i] != 0) return 0;
-  return 1;
+static int pieceFits(const Packer12 *pk, const Piece12 *p, int f) {
+  const int x0 = f % pk->w - p->anchorX;
+  return x0 >= 0 && x0 + p->w <= pk->w && f / pk->w + p->h <= pk->h &&
+         !pieceOverlaps(pk, f, p->mask);
+}
+
+static int nextEmpty(const Packer12 *pk, int f) {
+  while (f < pk->cells) {
+    uint64_t free = ~pk->occ[f >> 6] >> (f & 63);
+    if (free) return f + __builtin_ctzll(free);
+    f = (f | 63) + 1;
+  }
+  return pk->cells;
+}
+
+// out[0, n) = bits [f, f + 64n) of src.
+static void extractWindow(const uint64_t *src, int f, uint64_t *out, int n) {
+  src += f >> 6;
+  const int sh = f & 63;
+  for (int i = 0; i < n; ++i) {
+    out[i] = (src[i] >> sh) | (sh ? src[i + 1] << (64 - sh) : 0);
+  }
 }
 
-static int exactCanFitRec(const Placement12 *const *places,
-                          const int *placeCounts, int *counts, int nShapes,
-                          uint64_t *occ, int words) {
-  if (allCountsZero(counts, nShapes)) return 1;
-
-  int bestShape = -1;
-  int bestOptions = 0x7fffffff;
-  for (int si = 0; si < nShapes; ++si) {
-    if (counts[si] == 0) continue;
-    int opts = 0;
-    const Placement12 *plist = places[si];
-    const int pc = placeCounts[si];
-    for (int pi = 0; pi < pc; ++pi) {
-      if (!maskOverlaps(occ, &plist[pi].m, words)) {
-        opts++;
-        if (opts >= bestOptions) break;
+// Free cells in [f, f + span) that no remaining piece can still cover. Only
+// anchors at or after f are left and every piece fits inside one span, so
+// such a cell is wasted whatever happens next; once there are more of them
+// than the slack, the state is dead.
+static int uncoverableCells(Packer12 *pk, int f) {
+  const int n = pk->spanWords;
+  uint64_t *freeWin = pk->scratch;
+  uint64_t *fit = freeWin + 2 * n + 1;
+  uint64_t *covered = fit + n;
+  extractWindow(pk->occ, f, freeWin, 2 * n + 1);
+  for (int i = 0; i < 2 * n + 1; ++i) freeWin[i] = ~freeWin[i];
+  memset(covered, 0, (size_t)n * sizeof(uint64_t));
+
+  for (int s = 0; s < pk->nShapes; ++s) {
+    if (pk->counts[s] == 0) continue;
+    for (int pi = pk->pieceStart[s]; pi < pk->pieceStart[s + 1]; ++pi) {
+      const Piece12 *p = &pk->pieces[pi];
+      extractWindow(p->anchors, f, fit, n);
+      uint64_t any = 0;
+      for (int c = 0; c < p->cells && (c == 0 || any); ++c) {
+        const int wi = p->rel[c] >> 6;
+        const int sh = p->rel[c] & 63;
+        any = 0;
+        for (int i = 0; i < n; ++i) {
+          const uint64_t *src = freeWin + i + wi;
+          fit[i] &= (src[0] >> sh) | (sh ? src[1] << (64 - sh) : 0);
+          any |= fit[i];
+        }
+      }
+      if (!any) continue;
+      for (int c = 0; c < p->cells; ++c) {
+        const int wi = p->rel[c] >> 6;
+        const int sh = p->rel[c] & 63;
+        for (int i = n - 1; i >= wi; --i) {
+          uint64_t bits = fit[i - wi] << sh;
+          if (sh && i - wi > 0) bits |= fit[i - wi - 1] >> (64 - sh);
+          covered[i] |= bits;
+        }
       }
     }
-    if (opts == 0) return 0;
-    if (opts < bestOptions) {
-      bestOptions = opts;
-      bestShape = si;
-      if (bestOptions == 1) break;
+  }
+
+  int dead = 0;
+  for (int i = 0; i < n; ++i) {
+    dead += __builtin_popcountll(freeWin[i] & ~covered[i]);
+  }
+  return dead;
+}
+
+static void buildKey(Packer12 *pk, int f) {
+  const uint64_t *occ = pk->occ + (f >> 6);
+  const int sh = f & 63;
+  uint64_t *key = pk->key;
+  key[0] = (uint64_t)f + 1;
+  for (int i = 0; i < pk->spanWords; ++i) {
+    key[1 + i] = (occ[i] >> sh) | (sh ? occ[i + 1] << (64 - sh) : 0);
+  }
+  uint64_t *packed = key + 1 + pk->spanWords;
+  for (int i = 0; i < pk->nShapes; i += 2) {
+    uint64_t hi = i + 1 < pk->nShapes ? (uint64_t)(uint32_t)pk->counts[i + 1]
+                                      : 0;
+    packed[i / 2] = (uint64_t)(uint32_t)pk->counts[i] | (hi << 32);
+  }
+}
+
+static size_t hashKey(const uint64_t *key, int words) {
+  uint64_t h = 0x9E3779B97F4A7C15ULL;
+  for (int i = 0; i < words; ++i) {
+    h ^= key[i];
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 31;
+  }
+  return (size_t)h;
+}
+
+// Slot for key: either the matching entry or the empty slot it belongs in.
+static uint64_t *deadSlot(const DeadSet12 *set, const uint64_t *key,
+                          int words) {
+  size_t mask = set->capacity - 1;
+  size_t pos = hashKey(key, words) & mask;
+  for (;;) {
+    uint64_t *slot = set->keys + pos * (size_t)words;
+    if (slot[0] == 0 ||
+        memcmp(slot, key, (size_t)words * sizeof(uint64_t)) == 0) {
+      return slot;
     }
+    pos = (pos + 1) & mask;
   }
+}
 
-  counts[bestShape]--;
-  const Placement12 *plist = places[bestShape];
-  const int pc = placeCounts[bestShape];
-  for (int pi = 0; pi < pc; ++pi) {
-    if (maskOverlaps(occ, &plist[pi].m, words)) continue;
-    maskXor(occ, &plist[pi].m, words);
-    if (exactCanFitRec(places, placeCounts, counts, nShapes, occ, words))
-      return 1;
-    maskXor(occ, &plist[pi].m, words);
+static int deadInit(DeadSet12 *set, size_t capacity, int words) {
+  size_t bytes = capacity * (size_t)words * sizeof(uint64_t);
+  set->own = arenaCreate(bytes);
+  set->keys = arenaAllocZero(&set->own, capacity * (size_t)words,
+                             sizeof(uint64_t));
+  set->capacity = capacity;
+  set->count = 0;
+  return set->keys != NULL;
+}
+
+static void deadFree(DeadSet12 *set) {
+  arenaDestroy(&set->own);
+  set->keys = NULL;
+}
+
+static void deadInsert(DeadSet12 *set, const uint64_t *key, int words) {
+  if ((set->count + 1) * 2 > set->capacity) {
+    if (set->capacity >= D12_MEMO_MAX_SLOTS) return;
+    DeadSet12 grown;
+    if (!deadInit(&grown, set->capacity * 2, words)) {
+      deadFree(&grown);
+      return;
+    }
+    for (size_t i = 0; i < set->capacity; ++i) {
+      const uint64_t *old = set->keys + i * (size_t)words;
+      if (old[0] != 0) {
+        memcpy(deadSlot(&grown, old, words), old,
+               (size_t)words * sizeof(uint64_t));
+      }
+    }
+    grown.count = set->count;
+    deadFree(set);
+    *set = grown;
+  }
+  uint64_t *slot = deadSlot(set, key, words);
+  if (slot[0] == 0) {
+    memcpy(slot, key, (size_t)words * sizeof(uint64_t));
+    set->count++;
   }
-  counts[bestShape]++;
-  return 0;
 }
 
-static int exactCanFitSmall(const Region12 *r, const Shape12 *shapes) {
-  const int cells = r->w * r->h;
-  if (cells > D12_EXACT_MAX_CELLS) return 0;
-  if (r->totalArea > cells) return 0;
-
-  int totalPieces = 0;
-  for (int i = 0; i < r->nShapes; ++i) totalPieces += r->counts[i];
-  if (totalPieces == 0) return 1;
-  if (r->w < 3 || r->h < 3) return 0;
-
-  const int words = (cells + 63) / 64;
-  Placement12 **places = (Placement12 **)calloc((size_t)r->nShapes,
-                                                sizeof(Placement12 *));
-  int *placeCounts = (int *)calloc((size_t)r->nShapes, sizeof(int));
-  if (!places || !placeCounts) {
-    free(places);
-    free(placeCounts);
+static int packFrom(Packer12 *pk, int f) {
+  if (pk->remaining == 0) return 1;
+  f = nextEmpty(pk, f);
+  if (f >= pk->cells) return 0;
+  if (budgetSpent(pk)) {
+    pk->aborted = 1;
+    return 0;
+  }
+  STAT_INC(D12_SEARCH_NODES);
+
+  buildKey(pk, f);
+  if (deadSlot(&pk->dead, pk->key, pk->keyWords)[0] != 0) {
+    STAT_INC(D12_DEAD_HITS);
     return 0;
   }
+  if (uncoverableCells(pk, f) > pk->slack) return 0;
 
-  for (int si = 0; si < r->nShapes; ++si) {
-    if (r->counts[si] == 0) continue;
-    const Shape12 *s = &shapes[si];
-    int cap = 256;
-    int count = 0;
-    Placement12 *plist = (Placement12 *)malloc((size_t)cap * sizeof(*plist));
-    if (!plist) {
-      for (int j = 0; j < r->nShapes; ++j) free(places[j]);
-      free(places);
-      free(placeCounts);
-      return 0;
+  for (int s = 0; s < pk->nShapes; ++s) {
+    if (pk->counts[s] == 0) continue;
+    for (int i = pk->pieceStart[s]; i < pk->pieceStart[s + 1]; ++i) {
+      const Piece12 *p = &pk->pieces[i];
+      if (!pieceFits(pk, p, f)) continue;
+      pieceToggle(pk, f, p->mask);
+      pk->counts[s]--;
+      pk->remaining--;
+      int ok = packFrom(pk, f + 1);
+      pk->counts[s]++;
+      pk->remaining++;
+      pieceToggle(pk, f, p->mask);
+      if (ok) return 1;
+      if (pk->aborted) return 0;
     }
-    for (int oi = 0; oi < s->oriCount; ++oi) {
-      const ShapeOri *o = &s->ori[oi];
-      for (int y = 0; y <= r->h - o->h; ++y) {
-        for (int x = 0; x <= r->w - o->w; ++x) {
-          if (count >= cap) {
-            cap *= 2;
-            Placement12 *np =
-                (Placement12 *)realloc(plist, (size_t)cap * sizeof(*plist));
-            if (!np) {
-              free(plist);
-              for (int j = 0; j < r->nShapes; ++j) free(places[j]);
-              free(places);
-              free(placeCounts);
-              return 0;
-            }
-            plist = np;
-          }
-          memset(&plist[count], 0, sizeof(plist[count]));
-          for (int c = 0; c < o->cells; ++c) {
-            const int gx = x + o->coords[c][0];
-            const int gy = y + o->coords[c][1];
-            const int idx = gy * r->w + gx;
-            const int widx = idx >> 6;
-            const int bit = idx & 63;
-            plist[count].m.bits[widx] |= (1ULL << bit);
-          }
-          count++;
+  }
+  if (pk->slack > 0) {
+    pk->occ[f >> 6] |= 1ULL << (f & 63);
+    pk->slack--;
+    int ok = packFrom(pk, f + 1);
+    pk->slack++;
+    pk->occ[f >> 6] &= ~(1ULL << (f & 63));
+    if (ok) return 1;
+    if (pk->aborted) return 0;
+  }
+
+  buildKey(pk, f);
+  deadInsert(&pk->dead, pk->key, pk->keyWords);
+  STAT_INC(D12_DEAD_STORES);
+  return 0;
+}
+
+// Sufficient condition: give every piece its own disjoint box. A box of
+// boxA x boxB (boxA <= boxB) holds any used shape in some rotation.
+static int boxPackingFits(const Region12 *r, const Shape12 *shapes,
+                          long long pieces) {
+  int boxA = 0, boxB = 0;
+  for (int i = 0; i < r->nShapes; ++i) {
+    if (r->counts[i] == 0) continue;
+    const ShapeOri *o = &shapes[i].ori[0];
+    boxA = maxInt(boxA, minInt(o->w, o->h));
+    boxB = maxInt(boxB, maxInt(o->w, o->h));
+  }
+  long long across = (long long)(r->w / boxA) * (r->h / boxB);
+  long long down = (long long)(r->w / boxB) * (r->h / boxA);
+  return pieces <= (across > down ? across : down);
+}
+
+// The area and box checks settle most regions; returns 0 when only a search
+// can decide. Regions too large to search come back undecided.
+static int quickVerdict(const Region12 *r, const Shape12 *shapes,
+                        Fit12 *fit) {
+  const long long cells = (long long)r->w * r->h;
+  if (r->totalArea > cells) {
+    *fit = Fit12No;
+    return 1;
+  }
+  long long pieces = 0;
+  for (int i = 0; i < r->nShapes; ++i) pieces += r->counts[i];
+  if (pieces == 0 || boxPackingFits(r, shapes, pieces)) {
+    *fit = Fit12Yes;
+    return 1;
+  }
+  if (cells > D12_MAX_SEARCH_CELLS) {
+    *fit = Fit12Undecided;
+    return 1;
+  }
+  return 0;
+}
+
+// Every orientation of every shape that fits a w x h region, grouped by
+// shape. Pieces only depend on the shapes and the region size, so all
+// regions of one size share a table whatever their counts.
+typedef struct {
+  int w, h;
+  int spanWords;
+  int boardWords;
+  int pieceCount;
+  int pieceStart[D12_MAX_SHAPES + 1];
+  const Piece12 *pieces;
+} PlacementTable12;
+
+// Tables for one parsed shape set, open-addressed by region size. Built
+// before the regions are searched and read-only afterwards, so workers
+// share it without locking; it lives in the calling thread's scratch frame.
+typedef struct {
+  PlacementTable12 *tables;
+  size_t capacity;
+} PlacementCache12;
+
+static size_t dimsSlot(const PlacementCache12 *cache, int w, int h) {
+  size_t mask = cache->capacity - 1;
+  size_t pos = ((size_t)(unsigned)w * 0x9E3779B1u ^ (size_t)(unsigned)h) &
+               mask;
+  while (cache->tables[pos].w != 0 &&
+         (cache->tables[pos].w != w || cache->tables[pos].h != h)) {
+    pos = (pos + 1) & mask;
+  }
+  return pos;
+}
+
+static const PlacementTable12 *placementTable(const PlacementCache12 *cache,
+                                              int w, int h) {
+  if (cache->capacity == 0) return NULL;
+  const PlacementTable12 *t = &cache->tables[dimsSlot(cache, w, h)];
+  return t->w != 0 && t->pieces ? t : NULL;
+}
+
+// Words of a padded board bitboard: the board plus the widest window read
+// past any frontier (two spans and a carry word).
+static size_t occWords(int cells, int spanWords) {
+  return (size_t)(cells + 63) / 64 + 2 * (size_t)spanWords + 3;
+}
+
+// Zeroed bitboard words, aligned so a mask's first vector load never
+// straddles a cache line.
+static uint64_t *allocWords(Arena *arena, size_t words) {
+  uint64_t *p = arenaAllocAligned(arena, words * sizeof(uint64_t),
+                                  D12_WORD_ALIGN);
+  if (p) memset(p, 0, words * sizeof(uint64_t));
+  return p;
+}
+
+static int orientationFits(const ShapeOri *o, int w, int h) {
+  return o->w <= w && o->h <= h;
+}
+
+// Sizes a table: pieceCount and spanWords, the words one anchored mask spans.
+static void tableExtent(PlacementTable12 *t, const Shape12 *shapes,
+                        int shapeCount) {
+  int maxSpan = 1;
+  t->pieceCount = 0;
+  for (int s = 0; s < shapeCount; ++s) {
+    for (int oi = 0; oi < shapes[s].oriCount; ++oi) {
+      const ShapeOri *o = &shapes[s].ori[oi];
+      if (!orientationFits(o, t->w, t->h)) continue;
+      maxSpan = maxInt(maxSpan, (o->h - 1) * t->w + o->w);
+      t->pieceCount++;
+    }
+  }
+  t->spanWords = (maxSpan + 63) / 64;
+  t->boardWords = (int)occWords(t->w * t->h, t->spanWords);
+}
+
+static void tableFill(PlacementTable12 *t, const Shape12 *shapes,
+                      int shapeCount, Piece12 *pieces, uint64_t *masks,
+                      uint64_t *anchors) {
+  int n = 0;
+  for (int s = 0; s < shapeCount; ++s) {
+    t->pieceStart[s] = n;
+    for (int oi = 0; oi < shapes[s].oriCount; ++oi) {
+      const ShapeOri *o = &shapes[s].ori[oi];
+      if (!orientationFits(o, t->w, t->h)) continue;
+      int ax = o->w;
+      for (int c = 0; c < o->cells; ++c) {
+        if (o->coords[c][1] == 0) ax = minInt(ax, o->coords[c][0]);
+      }
+      Piece12 *p = &pieces[n];
+      uint64_t *mask = masks + (size_t)n * (size_t)t->spanWords;
+      uint64_t *valid = anchors + (size_t)n * (size_t)t->boardWords;
+      *p = (Piece12){.shape = s, .anchorX = ax, .w = o->w, .h = o->h,
+                     .cells = o->cells, .mask = mask, .anchors = valid};
+      for (int c = 0; c < o->cells; ++c) {
+        int rel = o->coords[c][1] * t->w + o->coords[c][0] - ax;
+        p->rel[c] = rel;
+        mask[rel >> 6] |= 1ULL << (rel & 63);
+      }
+      for (int y = 0; y + o->h <= t->h; ++y) {
+        for (int x = ax; x - ax + o->w <= t->w; ++x) {
+          int cell = y * t->w + x;
+          valid[cell >> 6] |= 1ULL << (cell & 63);
         }
       }
+      n++;
     }
-    places[si] = plist;
-    placeCounts[si] = count;
   }
+  t->pieceStart[shapeCount] = n;
+  t->pieces = pieces;
+}
 
-  uint64_t occ[D12_MAX_WORDS];
-  memset(occ, 0, sizeof(occ));
-  int counts[16];
-  for (int i = 0; i < r->nShapes; ++i) counts[i] = r->counts[i];
-  const int ok = exactCanFitRec((const Placement12 *const *)places, placeCounts,
-                                counts, r->nShapes, occ, words);
+// One table per distinct size among the regions that need a search. A table
+// that cannot be allocated is left without pieces, and regions of that size
+// come back undecided. Returns how many regions need a search.
+static int cacheBuild(PlacementCache12 *cache, Arena *arena,
+                      const Region12 *regions, int regionCount,
+                      const Shape12 *shapes, int shapeCount) {
+  memset(cache, 0, sizeof(*cache));
+  size_t capacity = D12_MIN_TABLE_SLOTS;
+  while (capacity < (size_t)regionCount * 2) capacity *= 2;
+  cache->tables = arenaAllocZero(arena, capacity, sizeof(PlacementTable12));
+  if (!cache->tables) return 0;
+  cache->capacity = capacity;
 
-  for (int j = 0; j < r->nShapes; ++j) free(places[j]);
-  free(places);
-  free(placeCounts);
-  return ok;
+  int searched = 0;
+  for (int r = 0; r < regionCount; ++r) {
+    Fit12 fit;
+    if (quickVerdict(&regions[r], shapes, &fit)) continue;
+    searched++;
+    PlacementTable12 *t =
+        &cache->tables[dimsSlot(cache, regions[r].w, regions[r].h)];
+    if (t->w != 0) continue;
+    STAT_TIMER_START(D12_PLACEMENT_TABLES);
+    t->w = regions[r].w;
+    t->h = regions[r].h;
+    tableExtent(t, shapes, shapeCount);
+    Piece12 *pieces =
+        arenaAllocZero(arena, (size_t)t->pieceCount, sizeof(Piece12));
+    uint64_t *masks =
+        allocWords(arena, (size_t)t->pieceCount * (size_t)t->spanWords);
+    uint64_t *anchors =
+        allocWords(arena, (size_t)t->pieceCount * (size_t)t->boardWords);
+    if (pieces && masks && anchors) {
+      tableFill(t, shapes, shapeCount, pieces, masks, anchors);
+    }
+    STAT_TIMER_STOP(D12_PLACEMENT_TABLES);
+  }
+  return searched;
 }
 
-static int regionCanFitFast(const Region12 *r) {
-  const int area = r->w * r->h;
-  if (r->totalArea > area) return 0;
-  int totalPieces = 0;
-  for (int i = 0; i < r->nShapes; ++i) totalPieces += r->counts[i];
-  if (totalPieces == 0) return 1;
-  if (r->w < 3 || r->h < 3) return 0;
+static void regionDeadline(const Day12Limits *limits,
+                           struct timespec *deadline) {
+  clock_gettime(CLOCK_MONOTONIC, deadline);
+  deadline->tv_sec += (time_t)(limits->timeBudgetMs / 1000);
+  deadline->tv_nsec += (long)(limits->timeBudgetMs % 1000) * 1000000L;
+  if (deadline->tv_nsec >= 1000000000L) {
+    deadline->tv_sec++;
+    deadline->tv_nsec -= 1000000000L;
+  }
+}
+
+// Sets pk up at the root of r's search, with its buffers and memo in arena.
+// Returns 0 when out of memory.
+static int packerInit(Packer12 *pk, Arena *arena, const Region12 *r,
+                      const PlacementTable12 *table, const Day12Limits *limits,
+                      const struct timespec *deadline, atomic_int *cancel) {
+  const int cells = r->w * r->h;
+  memset(pk, 0, sizeof(*pk));
+  pk->w = r->w;
+  pk->h = r->h;
+  pk->cells = cells;
+  pk->nShapes = r->nShapes;
+  pk->slack = cells - (int)r->totalArea;
+  pk->nodeBudget = limits->nodeBudget;
+  pk->cancel = cancel;
+  if (deadline) {
+    pk->deadline = *deadline;
+    pk->hasDeadline = 1;
+  }
+  for (int s = 0; s < r->nShapes; ++s) {
+    pk->counts[s] = r->counts[s];
+    pk->remaining += r->counts[s];
+  }
+  pk->pieces = table->pieces;
+  pk->pieceStart = table->pieceStart;
+  pk->spanWords = table->spanWords;
+  pk->keyWords = 1 + pk->spanWords + (r->nShapes + 1) / 2;
+
+  const size_t words = occWords(cells, pk->spanWords);
+  pk->occ = allocWords(arena, words);
+  pk->key = allocWords(arena, (size_t)pk->keyWords);
+  pk->scratch = allocWords(arena, 4 * (size_t)pk->spanWords + 1);
+  if (!pk->occ || !pk->key || !pk->scratch ||
+      !deadInit(&pk->dead, D12_MEMO_MIN_CAPACITY, pk->keyWords)) {
+    return 0;
+  }
+
+  // Cells past the board end count as occupied: nextEmpty stops there and
+  // the dead-cell check never counts them as free.
+  for (int c = cells; c < (cells + 63) / 64 * 64; ++c) {
+    pk->occ[c >> 6] |= 1ULL << (c & 63);
+  }
+  for (size_t i = (size_t)(cells + 63) / 64; i < words; ++i) {
+    pk->occ[i] = ~0ULL;
+  }
   return 1;
 }
 
-unsigned long long day12Solve(const char *data) {
+// Frees what packerInit set up outside its arena; safe after a failed init.
+static void packerFree(Packer12 *pk) { deadFree(&pk->dead); }
+
+static Fit12 serialSearch(const Region12 *r, const PlacementTable12 *table,
+                          const Day12Limits *limits, atomic_int *cancel) {
+  struct timespec deadline;
+  if (limits->timeBudgetMs) regionDeadline(limits, &deadline);
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  Packer12 pk;
+  Fit12 fit = Fit12Undecided;
+  if (packerInit(&pk, scratch, r, table, limits,
+                 limits->timeBudgetMs ? &deadline : NULL, cancel)) {
+    if (packFrom(&pk, 0)) {
+      fit = Fit12Yes;
+    } else if (!pk.aborted) {
+      fit = Fit12No;
+    }
+  }
+  packerFree(&pk);
+  arenaRelease(scratch, mark);
+  return fit;
+}
+
+// A search state below the root: what the decisions so far left behind.
+typedef struct {
+  int frontier;
+  int remaining;
+  int slack;
+  int counts[D12_MAX_SHAPES];
+  uint64_t *occ;
+} Subtree12;
+
+typedef struct {
+  const Region12 *region;
+  const PlacementTable12 *table;
+  const Day12Limits *limits;
+  const struct timespec *deadline;
+  const Subtree12 *subtrees;
+  atomic_int stop;
+  atomic_int found;
+  atomic_int aborted;
+  atomic_ullong nodes;
+} SplitSearch12;
+
+// Runs in the worker's task frame, which takes the packer with it; only the
+// dead-state table has to be freed.
+static void searchSubtree(void *ctx, size_t task, int worker) {
+  (void)worker;
+  SplitSearch12 *split = ctx;
+  const Subtree12 *sub = &split->subtrees[task];
+  Packer12 pk;
+  if (!packerInit(&pk, arenaScratch(), split->region, split->table,
+                  split->limits, split->deadline, &split->stop)) {
+    packerFree(&pk);
+    atomic_store(&split->aborted, 1);
+    return;
+  }
+  pk.sharedNodes = &split->nodes;
+  pk.remaining = sub->remaining;
+  pk.slack = sub->slack;
+  memcpy(pk.counts, sub->counts, sizeof(pk.counts));
+  memcpy(pk.occ, sub->occ,
+         occWords(pk.cells, pk.spanWords) * sizeof(uint64_t));
+
+  if (packFrom(&pk, sub->frontier)) {
+    atomic_store(&split->found, 1);
+    atomic_store(&split->stop, 1);
+  } else if (pk.aborted) {
+    atomic_store(&split->aborted, 1);
+  }
+  packerFree(&pk);
+}
+
+// Expands every subtree by one frontier decision. Returns the new count, or
+// -1 when some subtree is already a full packing.
+static int expandSubtrees(Packer12 *pk, const Subtree12 *from, int fromCount,
+                          Subtree12 *to, uint64_t *toOcc, size_t words) {
+  int count = 0;
+  for (int t = 0; t < fromCount; ++t) {
+    const Subtree12 *sub = &from[t];
+    if (sub->remaining == 0) return -1;
+    pk->occ = sub->occ;
+    int f = nextEmpty(pk, sub->frontier);
+    if (f >= pk->cells) continue;
+    for (int s = 0; s < pk->nShapes; ++s) {
+      if (sub->counts[s] == 0) continue;
+      for (int i = pk->pieceStart[s]; i < pk->pieceStart[s + 1]; ++i) {
+        const Piece12 *p = &pk->pieces[i];
+        if (!pieceFits(pk, p, f)) continue;
+        Subtree12 *child = &to[count];
+        *child = *sub;
+        child->occ = toOcc + (size_t)count * words;
+        memcpy(child->occ, sub->occ, words * sizeof(uint64_t));
+        pk->occ = child->occ;
+        pieceToggle(pk, f, p->mask);
+        pk->occ = sub->occ;
+        child->frontier = f + 1;
+        child->counts[s]--;
+        child->remaining--;
+        count++;
+      }
+    }
+    if (sub->slack > 0) {
+      Subtree12 *child = &to[count];
+      *child = *sub;
+      child->occ = toOcc + (size_t)count * words;
+      memcpy(child->occ, sub->occ, words * sizeof(uint64_t));
+      child->occ[f >> 6] |= 1ULL << (f & 63);
+      child->frontier = f + 1;
+      child->slack--;
+      count++;
+    }
+  }
+  return count;
+}
+
+// One region, many workers: the first few frontier decisions are expanded
+// breadth-first until there are enough subtrees to keep every worker busy,
+// then each subtree is searched as its own task with a private bitboard and
+// memo. The first packing found stops the others.
+static Fit12 splitSearch(const Region12 *r, const PlacementTable12 *table,
+                         const Day12Limits *limits) {
+  struct timespec deadline;
+  if (limits->timeBudgetMs) regionDeadline(limits, &deadline);
+  // Every level of the expansion stays in this frame until the end.
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  Packer12 root;
+  Fit12 fit = Fit12Undecided;
+  if (!packerInit(&root, scratch, r, table, limits, NULL, NULL)) goto done;
+  const size_t words = occWords(root.cells, root.spanWords);
+  const int target = parallelThreadCount() * D12_SPLIT_TASKS_PER_THREAD;
+  // A frontier decision has at most one child per piece plus leaving the
+  // cell empty.
+  const int fanout = table->pieceCount + 1;
+
+  Subtree12 *level = arenaAlloc(scratch, sizeof(Subtree12));
+  uint64_t *levelOcc = allocWords(scratch, words);
+  int count = 1;
+  if (!level || !levelOcc) goto done;
+  memcpy(levelOcc, root.occ, words * sizeof(uint64_t));
+  level[0] = (Subtree12){0, root.remaining, root.slack, {0}, levelOcc};
+  memcpy(level[0].counts, root.counts, sizeof(root.counts));
+
+  for (int depth = 0; depth < D12_SPLIT_MAX_DEPTH && count < target;
+       ++depth) {
+    size_t cap = (size_t)count * (size_t)fanout;
+    Subtree12 *next = arenaAlloc(scratch, cap * sizeof(Subtree12));
+    uint64_t *nextOcc = allocWords(scratch, cap * words);
+    if (!next || !nextOcc) break;
+    int expanded = expandSubtrees(&root, level, count, next, nextOcc, words);
+    level = next;
+    levelOcc = nextOcc;
+    if (expanded < 0) {
+      fit = Fit12Yes;
+      goto done;
+    }
+    count = expanded;
+    if (count == 0) {
+      fit = Fit12No;
+      goto done;
+    }
+  }
+
+  SplitSearch12 split = {
+      .region = r,
+      .table = table,
+      .limits = limits,
+      .deadline = limits->timeBudgetMs ? &deadline : NULL,
+      .subtrees = level,
+  };
+  atomic_init(&split.stop, 0);
+  atomic_init(&split.found, 0);
+  atomic_init(&split.aborted, 0);
+  atomic_init(&split.nodes, 0);
+  STAT_ADD(D12_SPLIT_SUBTREES, (unsigned long long)count);
+  parallelForDynamic((size_t)count, searchSubtree, &split, &split.stop);
+  if (atomic_load(&split.found)) {
+    fit = Fit12Yes;
+  } else if (!atomic_load(&split.aborted)) {
+    fit = Fit12No;
+  }
+
+done:
+  packerFree(&root);
+  arenaRelease(scratch, mark);
+  return fit;
+}
+
+static Fit12 exactCanFit(const Region12 *r, const Shape12 *shapes,
+                         const PlacementCache12 *cache,
+                         const Day12Limits *limits, atomic_int *cancel,
+                         int split) {
+  Fit12 fit;
+  if (quickVerdict(r, shapes, &fit)) return fit;
+  const PlacementTable12 *table = placementTable(cache, r->w, r->h);
+  if (!table) return Fit12Undecided;
+  return split ? splitSearch(r, table, limits)
+               : serialSearch(r, table, limits, cancel);
+}
+
+typedef struct {
+  const Region12 *regions;
+  const Shape12 *shapes;
+  const PlacementCache12 *cache;
+  const Day12Limits *limits;
+  unsigned char *verdicts;
+  atomic_int cancel;
+} RegionBatch;
+
+static void evaluateRegion(void *ctx, size_t task, int worker) {
+  (void)worker;
+  RegionBatch *batch = ctx;
+  Fit12 fit = exactCanFit(&batch->regions[task], batch->shapes, batch->cache,
+                          batch->limits, &batch->cancel, 0);
+  batch->verdicts[task] = (unsigned char)fit;
+  if (fit == Fit12Undecided && batch->limits->stopWhenUndecided) {
+    atomic_store(&batch->cancel, 1);
+  }
+}
+
+// Returns 0 only when parsing fails; out is filled in either way.
+static int countRegions(const char *data, size_t size,
+                        const Day12Limits *limits, const ParseError *err,
+                        Arena *scratch, Day12Result *out) {
+  static const Day12Limits unlimited = {0, 0, 0};
+  Day12Result result = {0, 0, 0};
+  *out = result;
   Shape12 shapes[16];
   int shapeCount = 0;
   Region12 *regions = NULL;
   int regionCount = 0;
-  if (!parseInput(data, shapes, &shapeCount, &regions, &regionCount)) return 0;
+  if (!parseInput(data, size, scratch, err, shapes, &shapeCount, &regions,
+                  &regionCount)) {
+    return 0;
+  }
+
+  unsigned char *verdicts = arenaAlloc(scratch, (size_t)regionCount + 1);
+  if (!verdicts) return 1;
+  // Regions left at Fit12Skipped were never started.
+  memset(verdicts, Fit12Skipped, (size_t)regionCount + 1);
+  PlacementCache12 cache;
+  const int searched =
+      cacheBuild(&cache, scratch, regions, regionCount, shapes, shapeCount);
+  RegionBatch batch = {
+      .regions = regions,
+      .shapes = shapes,
+      .cache = &cache,
+      .limits = limits ? limits : &unlimited,
+      .verdicts = verdicts,
+  };
+  atomic_init(&batch.cancel, 0);
+  if (parallelThreadCount() > 1 && searched < parallelThreadCount()) {
+    // Too few hard regions to keep the pool busy: take the regions one at a
+    // time and split each search across all workers instead.
+    for (int r = 0; r < regionCount; ++r) {
+      Fit12 fit = exactCanFit(&regions[r], shapes, &cache, batch.limits, NULL,
+                              1);
+      verdicts[r] = (unsigned char)fit;
+      if (fit == Fit12Undecided && batch.limits->stopWhenUndecided) break;
+    }
+  } else {
+    parallelForDynamic((size_t)regionCount, evaluateRegion, &batch,
+                       &batch.cancel);
+  }
 
-  unsigned long long fit = 0;
   for (int r = 0; r < regionCount; ++r) {
-    const Region12 *reg = &regions[r];
-    const int cells = reg->w * reg->h;
-    if (cells <= D12_EXACT_MAX_CELLS) {
-      if (exactCanFitSmall(reg, shapes)) fit++;
-      continue;
+    switch ((Fit12)verdicts[r]) {
+    case Fit12Yes:
+      result.fit++;
+      break;
+    case Fit12Undecided:
+      result.undecided++;
+      break;
+    case Fit12Skipped:
+      result.skipped++;
+      break;
+    case Fit12No:
+      break;
     }
-    if (regionCanFitFast(reg)) fit++;
   }
 
-  free(regions);
-  return fit;
+  *out = result;
+  return 1;
+}
+
+Day12Result day12Count(const char *data, const Day12Limits *limits) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  Day12Result result;
+  countRegions(data, strlen(data), limits, NULL, scratch, &result);
+  arenaRelease(scratch, mark);
+  return result;
+}
+
+int day12CountStrict(const char *data, size_t size, const Day12Limits *limits,
+                     Day12Result *out, char *errBuf, size_t errBufSize) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  const ParseError err = {errBuf, errBufSize};
+  int ok = countRegions(data, size, limits, &err, scratch, out);
+  arenaRelease(scratch, mark);
+  return ok;
+}
+
+int day12Validate(const char *data, size_t size, char *errBuf,
+                  size_t errBufSize) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  const ParseError err = {errBuf, errBufSize};
+  Shape12 shapes[D12_MAX_SHAPES];
+  int shapeCount = 0;
+  Region12 *regions = NULL;
+  int regionCount = 0;
+  int ok = parseInput(data, size, scratch, &err, shapes, &shapeCount,
+                      &regions, &regionCount);
+  arenaRelease(scratch, mark);
+  return ok;
+}
+
+unsigned long long day12Solve(const char *data) {
+  return day12Count(data, NULL).fit;
 }
 
 unsigned long long day12SolvePartTwo(const char *data) {
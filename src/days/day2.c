@@ -1,7 +1,14 @@
 #include "days/day2.h"
 
 #include <stdint.h>
-#include <stdlib.h>
+#include <string.h>
+
+// Range bounds are parsed into 128 bits. Values that fit in 64 bits take the
+// native division and multiplication paths below; only genuinely wide bounds
+// pay for the 128-bit library calls.
+__extension__ typedef unsigned __int128 WideId;
+
+#define WIDE_U64_MAX ((WideId)UINT64_MAX)
 
 static unsigned long long pow10u(int exp) {
   static const unsigned long long pow10[] = {
@@ -24,112 +31,197 @@ static unsigned long long pow10u(int exp) {
       10000000000000000ULL,
       100000000000000000ULL,
       1000000000000000000ULL,
+      10000000000000000000ULL,
   };
   return pow10[exp];
 }
 
-static int digitCount(unsigned long long value) {
+static int digitCount(WideId value) {
   int count = 1;
-  while (value >= 10ULL) {
-    value /= 10ULL;
+  while (value > WIDE_U64_MAX) {
+    value /= 10U;
+    count++;
+  }
+  unsigned long long narrow = (unsigned long long)value;
+  while (narrow >= 10ULL) {
+    narrow /= 10ULL;
     count++;
   }
   return count;
 }
 
-static int hasSmallerRepeat(unsigned long long value, int digits) {
-  char buf[20];
-  int idx = digits - 1;
-  unsigned long long tmp = value;
-  while (idx >= 0) {
-    buf[idx] = (char)('0' + (tmp % 10ULL));
-    tmp /= 10ULL;
-    idx--;
+static WideId divide(WideId a, WideId b) {
+  if (a < b) {
+    return 0;
   }
+  if (a <= WIDE_U64_MAX) {
+    return (unsigned long long)a / (unsigned long long)b;
+  }
+  return a / b;
+}
 
-  for (int sub = 1; sub <= digits / 2; ++sub) {
-    if (digits % sub != 0) {
-      continue;
+static WideId parseBound(const char *p, const char **endOut) {
+  WideId value = 0;
+  while (*p >= '0' && *p <= '9') {
+    value = value * 10U + (unsigned)(*p - '0');
+    p++;
+  }
+  *endOut = p;
+  return value;
+}
+
+// Two's-complement add/subtract into the 256-bit total. Part 2's
+// inclusion-exclusion can pass through negative partial sums; the final
+// total is always exact.
+static void totalAdd(Day2Total *total, const unsigned long long value[4],
+                     int negate) {
+  unsigned long long carry = negate ? 1ULL : 0ULL;
+  for (int i = 0; i < DAY2_TOTAL_LIMBS; ++i) {
+    unsigned long long v = negate ? ~value[i] : value[i];
+    unsigned long long sum = total->limbs[i] + v;
+    unsigned long long c1 = sum < v;
+    sum += carry;
+    carry = c1 | (sum < carry);
+    total->limbs[i] = sum;
+  }
+}
+
+// Full 128 x 128 -> 256-bit product.
+static void mulWide(WideId a, WideId b, unsigned long long out[4]) {
+  unsigned long long x[2] = {(unsigned long long)a,
+                             (unsigned long long)(a >> 64)};
+  unsigned long long y[2] = {(unsigned long long)b,
+                             (unsigned long long)(b >> 64)};
+  memset(out, 0, 4 * sizeof(out[0]));
+  for (int i = 0; i < 2; ++i) {
+    unsigned long long carry = 0;
+    for (int j = 0; j < 2; ++j) {
+      WideId t = (WideId)x[i] * y[j] + out[i + j] + carry;
+      out[i + j] = (unsigned long long)t;
+      carry = (unsigned long long)(t >> 64);
     }
-    int ok = 1;
-    for (int i = sub; i < digits; ++i) {
-      if (buf[i] != buf[i % sub]) {
-        ok = 0;
-        break;
-      }
+    out[i + 2] = carry;
+  }
+}
+
+// Möbius function for the small repeat counts an ID can have.
+static int mobius(int n) {
+  int result = 1;
+  for (int f = 2; f * f <= n; ++f) {
+    if (n % f != 0) {
+      continue;
     }
-    if (ok) {
-      return 1;
+    n /= f;
+    if (n % f == 0) {
+      return 0;
     }
+    result = -result;
   }
-  return 0;
+  return n > 1 ? -result : result;
 }
 
-static int maxPow10Index(void) { return 18; }
+// Adds (or subtracts) the sum of prefix * multiplier over prefix in [lo, hi].
+// Exactly one of (lo + hi) and the term count is even, so halve that one; the
+// prefix sum then fits in 128 bits because prefixes have at most 19 digits.
+static void addSeries(Day2Total *total, unsigned long long lo,
+                      unsigned long long hi, WideId multiplier, int negate) {
+  WideId pairSum = (WideId)lo + hi;
+  WideId terms = (WideId)(hi - lo) + 1U;
+  if (terms % 2U == 0) {
+    terms /= 2U;
+  } else {
+    pairSum /= 2U;
+  }
+  WideId prefixSum = pairSum * terms;
+
+  unsigned long long value[4] = {0, 0, 0, 0};
+  unsigned long long narrow;
+  if (prefixSum <= WIDE_U64_MAX && multiplier <= WIDE_U64_MAX &&
+      !__builtin_mul_overflow((unsigned long long)prefixSum,
+                              (unsigned long long)multiplier, &narrow)) {
+    value[0] = narrow;
+  } else {
+    mulWide(prefixSum, multiplier, value);
+  }
+  totalAdd(total, value, negate);
+}
+
+// Adds the sum of every blockDigits-digit prefix p with
+// start <= p * multiplier <= end.
+static void addRepeats(Day2Total *total, WideId start, WideId end,
+                       int blockDigits, WideId multiplier, int negate) {
+  WideId prefixStart = divide(start, multiplier);
+  if (prefixStart * multiplier != start) {
+    prefixStart++;
+  }
+  WideId prefixEnd = divide(end, multiplier);
+  WideId minPrefix = pow10u(blockDigits - 1);
+  WideId maxPrefix = pow10u(blockDigits) - 1ULL;
+  if (prefixStart < minPrefix) {
+    prefixStart = minPrefix;
+  }
+  if (prefixEnd > maxPrefix) {
+    prefixEnd = maxPrefix;
+  }
+  if (prefixStart > prefixEnd) {
+    return;
+  }
+  addSeries(total, (unsigned long long)prefixStart,
+            (unsigned long long)prefixEnd, multiplier, negate);
+}
 
 static int buildMultiplier(int blockDigits, int repeats,
-                           unsigned long long *outMultiplier) {
-  unsigned long long pow = pow10u(blockDigits);
-  unsigned long long multiplier = 0;
+                           WideId *outMultiplier) {
+  WideId pow = pow10u(blockDigits);
+  WideId multiplier = 0;
   for (int i = 0; i < repeats; ++i) {
-    if (multiplier > (UINT64_MAX - 1ULL) / pow) {
+    if (multiplier > (~(WideId)0 - 1U) / pow) {
       return 0;
     }
-    multiplier = multiplier * pow + 1ULL;
+    multiplier = multiplier * pow + 1U;
   }
   *outMultiplier = multiplier;
   return 1;
 }
 
-static unsigned long long day2SumInvalidIds(unsigned long long start,
-                                            unsigned long long end) {
-  if (start > end) {
-    unsigned long long tmp = start;
-    start = end;
-    end = tmp;
-  }
-
-  unsigned long long total = 0;
+static void day2SumInvalidIds(Day2Total *total, WideId start, WideId end) {
   int maxDigits = digitCount(end);
-  int maxHalf = maxDigits / 2;
-  if (maxHalf > 9) {
-    maxHalf = 9;
+  for (int half = 1; half <= maxDigits / 2; ++half) {
+    addRepeats(total, start, end, half, (WideId)pow10u(half) + 1U, 0);
   }
+}
 
-  for (int half = 1; half <= maxHalf; ++half) {
-    unsigned long long factor = pow10u(half);
-    unsigned long long multiplier = factor + 1ULL;
-    unsigned long long minPrefix = pow10u(half - 1);
-    unsigned long long maxPrefix = factor - 1ULL;
-
-    unsigned long long prefixStart = (start + multiplier - 1ULL) / multiplier;
-    if (prefixStart < minPrefix) {
-      prefixStart = minPrefix;
-    }
-
-    unsigned long long prefixEnd = end / multiplier;
-    if (prefixEnd > maxPrefix) {
-      prefixEnd = maxPrefix;
-    }
-
-    if (prefixStart > prefixEnd) {
-      continue;
-    }
+// IDs of D digits made of a d-digit block repeated D/d times are exactly the
+// D-digit numbers with period d. A number has several such periods (all
+// multiples of its primitive one), so the union over proper divisors d of D
+// is taken by Möbius inversion:
+//   sum(union) = -sum_{d | D, d < D} mu(D / d) * sum(period d).
+static void day2SumInvalidIdsAtLeastTwo(Day2Total *total, WideId start,
+                                        WideId end) {
+  int maxDigits = digitCount(end);
 
-    for (unsigned long long prefix = prefixStart; prefix <= prefixEnd;
-         ++prefix) {
-      unsigned long long candidate = prefix * multiplier;
-      if (candidate >= start && candidate <= end) {
-        total += candidate;
+  for (int digits = 2; digits <= maxDigits; ++digits) {
+    for (int blockDigits = 1; blockDigits < digits; ++blockDigits) {
+      if (digits % blockDigits != 0) {
+        continue;
       }
+      int mu = mobius(digits / blockDigits);
+      if (mu == 0) {
+        continue;
+      }
+      WideId multiplier;
+      if (!buildMultiplier(blockDigits, digits / blockDigits, &multiplier)) {
+        continue;
+      }
+      addRepeats(total, start, end, blockDigits, multiplier, mu > 0);
     }
   }
-
-  return total;
 }
 
-unsigned long long day2Solve(const char *data) {
-  unsigned long long total = 0;
+typedef void (*RangeSumFn)(Day2Total *total, WideId start, WideId end);
+
+static Day2Total sumRanges(const char *data, RangeSumFn sumRange) {
+  Day2Total total = {{0, 0, 0, 0}};
   const char *p = data;
 
   while (*p) {
@@ -140,8 +232,8 @@ unsigned long long day2Solve(const char *data) {
       break;
     }
 
-    char *endPtr;
-    unsigned long long rangeStart = strtoull(p, &endPtr, 10);
+    const char *endPtr;
+    WideId rangeStart = parseBound(p, &endPtr);
     if (endPtr == p) {
       break;
     }
@@ -158,13 +250,18 @@ unsigned long long day2Solve(const char *data) {
     while (*p == ' ') {
       p++;
     }
-    unsigned long long rangeEnd = strtoull(p, &endPtr, 10);
+    WideId rangeEnd = parseBound(p, &endPtr);
     if (endPtr == p) {
       break;
     }
     p = endPtr;
 
-    total += day2SumInvalidIds(rangeStart, rangeEnd);
+    if (rangeStart > rangeEnd) {
+      WideId tmp = rangeStart;
+      rangeStart = rangeEnd;
+      rangeEnd = tmp;
+    }
+    sumRange(&total, rangeStart, rangeEnd);
 
     while (*p && *p != ',' && *p != '\n' && *p != '\r') {
       p++;
@@ -177,107 +274,47 @@ unsigned long long day2Solve(const char *data) {
   return total;
 }
 
-static unsigned long long day2SumInvalidIdsAtLeastTwo(unsigned long long start,
-                                                      unsigned long long end) {
-  if (start > end) {
-    unsigned long long tmp = start;
-    start = end;
-    end = tmp;
-  }
-
-  unsigned long long total = 0;
-  int maxDigits = digitCount(end);
-
-  for (int blockDigits = 1;
-       blockDigits <= maxDigits && blockDigits <= maxPow10Index(); ++blockDigits) {
-    unsigned long long minPrefix = pow10u(blockDigits - 1);
-    unsigned long long maxPrefix = pow10u(blockDigits) - 1ULL;
-    int maxRepeats = maxDigits / blockDigits;
-
-    for (int repeats = 2; repeats <= maxRepeats; ++repeats) {
-      unsigned long long multiplier;
-      if (!buildMultiplier(blockDigits, repeats, &multiplier)) {
-        break;
-      }
-
-      unsigned long long prefixStart = (start + multiplier - 1ULL) / multiplier;
-      unsigned long long prefixEnd = end / multiplier;
-
-      if (prefixStart < minPrefix) {
-        prefixStart = minPrefix;
-      }
-      if (prefixEnd > maxPrefix) {
-        prefixEnd = maxPrefix;
-      }
-
-      if (prefixStart > prefixEnd) {
-        continue;
-      }
-
-      for (unsigned long long prefix = prefixStart; prefix <= prefixEnd;
-           ++prefix) {
-        if (hasSmallerRepeat(prefix, blockDigits)) {
-          continue;
-        }
-        if (prefix > UINT64_MAX / multiplier) {
-          break;
-        }
-        unsigned long long candidate = prefix * multiplier;
-        if (candidate >= start && candidate <= end) {
-          total += candidate;
-        }
-      }
-    }
-  }
-
-  return total;
+Day2Total day2Solve(const char *data) {
+  return sumRanges(data, day2SumInvalidIds);
 }
 
-unsigned long long day2SolvePartTwo(const char *data) {
-  unsigned long long total = 0;
-  const char *p = data;
-
-  while (*p) {
-    while (*p == ',' || *p == '\n' || *p == '\r' || *p == ' ' || *p == '\t') {
-      p++;
-    }
-    if (*p == '\0') {
-      break;
-    }
-
-    char *endPtr;
-    unsigned long long rangeStart = strtoull(p, &endPtr, 10);
-    if (endPtr == p) {
-      break;
-    }
-    p = endPtr;
-
-    while (*p == ' ') {
-      p++;
-    }
-    if (*p != '-') {
-      break;
-    }
-    p++;
+Day2Total day2SolvePartTwo(const char *data) {
+  return sumRanges(data, day2SumInvalidIdsAtLeastTwo);
+}
 
-    while (*p == ' ') {
-      p++;
-    }
-    unsigned long long rangeEnd = strtoull(p, &endPtr, 10);
-    if (endPtr == p) {
-      break;
+const char *day2FormatTotal(Day2Total total, char *buf, size_t size) {
+  char digits[DAY2_TOTAL_DIGITS + 1];
+  int len = 0;
+  int top = DAY2_TOTAL_LIMBS;
+  while (top > 0 && total.limbs[top - 1] == 0) {
+    top--;
+  }
+  // Repeated division by 10^19 peels off 19 decimal digits per pass.
+  while (top > 0) {
+    unsigned long long rem = 0;
+    for (int i = top - 1; i >= 0; --i) {
+      WideId cur = ((WideId)rem << 64) | total.limbs[i];
+      total.limbs[i] = (unsigned long long)(cur / pow10u(19));
+      rem = (unsigned long long)(cur % pow10u(19));
     }
-    p = endPtr;
-
-    total += day2SumInvalidIdsAtLeastTwo(rangeStart, rangeEnd);
-
-    while (*p && *p != ',' && *p != '\n' && *p != '\r') {
-      p++;
+    while (top > 0 && total.limbs[top - 1] == 0) {
+      top--;
     }
-    if (*p == ',') {
-      p++;
+    for (int i = 0; i < 19 && (top > 0 || rem != 0); ++i) {
+      digits[len++] = (char)('0' + rem % 10ULL);
+      rem /= 10ULL;
     }
   }
+  if (len == 0) {
+    digits[len++] = '0';
+  }
 
-  return total;
+  size_t out = 0;
+  while (len > 0 && out + 1 < size) {
+    buf[out++] = digits[--len];
+  }
+  if (size > 0) {
+    buf[out] = '\0';
+  }
+  return buf;
 }
@@ -1,95 +1,304 @@
 #include "days/day3.h"
 
+#include "parallel.h"
+
 #include <stddef.h>
 
-unsigned long long day3Solve(const char *data) {
-  unsigned long long sum = 0;
-  const char *p = data;
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
-  while (*p) {
-    int bestLead = -1;
-    int best = -1;
+enum {
+  D3_PART_TWO_DIGITS = 12,
+  // Inputs smaller than this per extra thread are summed serially.
+  D3_PARALLEL_MIN_BYTES = 1 << 20,
+  // Below this the monotonic stack wins; above it each of the k picks is a
+  // vector max-reduction over a window that usually ends at the first '9'.
+  D3_SEGMENT_MIN_DIGITS = 64
+};
 
-    while (*p && *p != '\n') {
-      char c = *p++;
-      if (c < '0' || c > '9') {
-        continue;
-      }
-      int digit = c - '0';
-      if (bestLead >= 0) {
-        int candidate = bestLead * 10 + digit;
-        if (candidate > best) {
-          best = candidate;
-        }
-      }
-      if (digit > bestLead) {
-        bestLead = digit;
-      }
+// Returns the length of the line starting at p (up to '\n' or end) and
+// whether every byte in it is a digit, in a single pass.
+static size_t scanLine(const char *p, const char *end, int *allDigits) {
+  const char *q = p;
+  int digitsOnly = 1;
+#ifdef __AVX2__
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i zero = _mm256_set1_epi8('0');
+  const __m256i nine = _mm256_set1_epi8(9);
+  while (end - q >= 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)q);
+    __m256i offset = _mm256_sub_epi8(v, zero);
+    __m256i isDigit = _mm256_cmpeq_epi8(_mm256_max_epu8(offset, nine), nine);
+    unsigned nl =
+        (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+    unsigned bad = ~(unsigned)_mm256_movemask_epi8(isDigit);
+    if (nl) {
+      unsigned before = (1u << __builtin_ctz(nl)) - 1u;
+      *allDigits = digitsOnly && (bad & before) == 0;
+      return (size_t)(q - p) + (size_t)__builtin_ctz(nl);
     }
+    digitsOnly &= (bad == 0);
+    q += 32;
+  }
+#endif
+  while (q < end && *q != '\n') {
+    digitsOnly &= (*q >= '0' && *q <= '9');
+    q++;
+  }
+  *allDigits = digitsOnly;
+  return (size_t)(q - p);
+}
 
-    if (best >= 0) {
-      sum += (unsigned long long)best;
+// Index of the first occurrence of the largest byte in s[from, to).
+static size_t firstMax(const char *s, size_t from, size_t to) {
+  size_t i = from;
+  unsigned char best = 0;
+#ifdef __AVX2__
+  const __m256i nines = _mm256_set1_epi8('9');
+  __m256i vmax = _mm256_setzero_si256();
+  for (; i + 32 <= to; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+    unsigned m9 =
+        (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nines));
+    if (m9) {
+      return i + (size_t)__builtin_ctz(m9);
     }
+    vmax = _mm256_max_epu8(vmax, v);
+  }
+  __m128i m = _mm_max_epu8(_mm256_castsi256_si128(vmax),
+                           _mm256_extracti128_si256(vmax, 1));
+  m = _mm_max_epu8(m, _mm_srli_si128(m, 8));
+  m = _mm_max_epu8(m, _mm_srli_si128(m, 4));
+  m = _mm_max_epu8(m, _mm_srli_si128(m, 2));
+  m = _mm_max_epu8(m, _mm_srli_si128(m, 1));
+  best = (unsigned char)_mm_cvtsi128_si32(m);
+#endif
+  for (size_t j = i; j < to; ++j) {
+    unsigned char c = (unsigned char)s[j];
+    if (c == '9') {
+      // Nothing earlier can be a '9', or the block scan would have stopped.
+      best = '9';
+      break;
+    }
+    if (c > best) {
+      best = c;
+    }
+  }
 
-    if (*p == '\n') {
-      p++;
+  i = from;
+#ifdef __AVX2__
+  const __m256i target = _mm256_set1_epi8((char)best);
+  for (; i + 32 <= to; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+    unsigned hit =
+        (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, target));
+    if (hit) {
+      return i + (size_t)__builtin_ctz(hit);
     }
   }
+#endif
+  while (i < to && (unsigned char)s[i] != best) {
+    i++;
+  }
+  return i;
+}
 
-  return sum;
+// Largest k-digit subsequence of an all-digit line with len >= k: pick each
+// output digit as the leftmost maximum of the window that still leaves room
+// for the remaining picks.
+static unsigned long long segmentMaxK(const char *line, size_t len, int k) {
+  unsigned long long value = 0;
+  size_t pos = 0;
+  for (int picked = 0; picked < k; ++picked) {
+    size_t windowEnd = len - (size_t)(k - picked) + 1;
+    size_t idx = firstMax(line, pos, windowEnd);
+    value = value * 10ULL + (unsigned long long)(line[idx] - '0');
+    pos = idx + 1;
+  }
+  return value;
 }
 
-static unsigned long long maxSubsequenceK(const char *line, int k) {
-  const char *p = line;
+// Monotonic-stack selection for an all-digit line of known length.
+static unsigned long long stackMaxK(const char *line, size_t len, int k) {
+  char chosen[DAY3_MAX_DIGITS];
+  int top = 0;
+  for (size_t i = 0; i < len; ++i) {
+    char c = line[i];
+    size_t remaining = len - i - 1;
+    while (top > 0 && chosen[top - 1] < c &&
+           (size_t)top + remaining >= (size_t)k) {
+      top--;
+    }
+    if (top < k) {
+      chosen[top++] = c;
+    }
+  }
+
+  unsigned long long value = 0;
+  for (int i = 0; i < top; ++i) {
+    value = value * 10ULL + (unsigned long long)(chosen[i] - '0');
+  }
+  return value;
+}
+
+static unsigned long long bestPair(const char *line, size_t len) {
+  int bestLead = -1;
+  int best = -1;
+  for (size_t i = 0; i < len; ++i) {
+    char c = line[i];
+    if (c < '0' || c > '9') {
+      continue;
+    }
+    int digit = c - '0';
+    if (bestLead >= 0) {
+      int candidate = bestLead * 10 + digit;
+      if (candidate > best) {
+        best = candidate;
+      }
+    }
+    if (digit > bestLead) {
+      bestLead = digit;
+    }
+  }
+  return best >= 0 ? (unsigned long long)best : 0ULL;
+}
+
+// Fallback for lines carrying stray non-digits (e.g. '\r'): count digits,
+// then run the monotonic stack while skipping everything else.
+static unsigned long long maxSubsequenceK(const char *line, size_t len,
+                                          int k) {
   int total = 0;
-  while (*p && *p != '\n') {
-    if (*p >= '0' && *p <= '9') {
+  for (size_t i = 0; i < len; ++i) {
+    if (line[i] >= '0' && line[i] <= '9') {
       total++;
     }
-    p++;
   }
 
-  char chosen[12];
-  int len = 0;
-  p = line;
+  char chosen[DAY3_MAX_DIGITS];
+  int top = 0;
   int remaining = total;
 
-  while (*p && *p != '\n') {
-    char c = *p++;
+  for (size_t i = 0; i < len; ++i) {
+    char c = line[i];
     if (c < '0' || c > '9') {
       continue;
     }
     remaining--;
-    while (len > 0 && chosen[len - 1] < c && (len + remaining) >= k) {
-      len--;
+    while (top > 0 && chosen[top - 1] < c && (top + remaining) >= k) {
+      top--;
     }
-    if (len < k) {
-      chosen[len++] = c;
+    if (top < k) {
+      chosen[top++] = c;
     }
   }
 
   unsigned long long value = 0;
-  for (int i = 0; i < len; ++i) {
+  for (int i = 0; i < top; ++i) {
     value = value * 10ULL + (unsigned long long)(chosen[i] - '0');
   }
   return value;
 }
 
-unsigned long long day3SolvePartTwo(const char *data) {
-  unsigned long long sum = 0;
-  const char *p = data;
+static unsigned long long pairValue(const char *line, size_t len,
+                                    int allDigits, int k) {
+  if (!allDigits) {
+    return bestPair(line, len);
+  }
+  return len >= (size_t)k ? segmentMaxK(line, len, k) : 0ULL;
+}
 
-  while (*p) {
-    unsigned long long value = maxSubsequenceK(p, 12);
-    sum += value;
+static unsigned long long subsequenceValue(const char *line, size_t len,
+                                           int allDigits, int k) {
+  if (!allDigits) {
+    return maxSubsequenceK(line, len, k);
+  }
+  if (len >= D3_SEGMENT_MIN_DIGITS) {
+    return segmentMaxK(line, len, k);
+  }
+  return stackMaxK(line, len, k);
+}
 
-    while (*p && *p != '\n') {
-      p++;
-    }
-    if (*p == '\n') {
+typedef unsigned long long (*LineValueFn)(const char *line, size_t len,
+                                          int allDigits, int k);
+
+static unsigned long long sumLines(const char *p, const char *end,
+                                   LineValueFn value, int k) {
+  unsigned long long sum = 0;
+  while (p < end) {
+    int allDigits;
+    size_t len = scanLine(p, end, &allDigits);
+    sum += value(p, len, allDigits, k);
+
+    p += len;
+    if (p < end && *p == '\n') {
       p++;
     }
   }
-
   return sum;
 }
+
+typedef struct {
+  const char *data;
+  size_t size;
+  size_t chunks;
+  LineValueFn value;
+  int k;
+  unsigned long long *sums;
+} LineBatch;
+
+static void sumChunk(void *ctx, size_t chunk, int worker) {
+  (void)worker;
+  LineBatch *batch = ctx;
+  const char *begin =
+      parallelLineChunk(batch->data, batch->size, batch->chunks, chunk);
+  const char *end =
+      parallelLineChunk(batch->data, batch->size, batch->chunks, chunk + 1);
+  batch->sums[chunk] =
+      begin < end ? sumLines(begin, end, batch->value, batch->k) : 0ULL;
+}
+
+// Lines are independent, so the input is split at newlines into one chunk per
+// thread and the per-chunk sums are reduced at the end.
+static unsigned long long sumLinesParallel(const char *data, size_t size,
+                                           LineValueFn value, int k) {
+  size_t chunks = parallelChunkCount(size, D3_PARALLEL_MIN_BYTES);
+  if (chunks <= 1) {
+    return sumLines(data, data + size, value, k);
+  }
+
+  unsigned long long sums[256];
+  if (chunks > sizeof(sums) / sizeof(sums[0])) {
+    chunks = sizeof(sums) / sizeof(sums[0]);
+  }
+  LineBatch batch = {
+      .data = data,
+      .size = size,
+      .chunks = chunks,
+      .value = value,
+      .k = k,
+      .sums = sums,
+  };
+  parallelFor(chunks, sumChunk, &batch);
+
+  unsigned long long total = 0;
+  for (size_t i = 0; i < chunks; ++i) {
+    total += sums[i];
+  }
+  return total;
+}
+
+unsigned long long day3Solve(const char *data, size_t size) {
+  return sumLinesParallel(data, size, pairValue, 2);
+}
+
+unsigned long long day3SolveK(const char *data, size_t size, int k) {
+  if (k < 1 || k > DAY3_MAX_DIGITS) {
+    return 0;
+  }
+  return sumLinesParallel(data, size, subsequenceValue, k);
+}
+
+unsigned long long day3SolvePartTwo(const char *data, size_t size) {
+  return day3SolveK(data, size, D3_PART_TWO_DIGITS);
+}
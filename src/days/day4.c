@@ -2,10 +2,9 @@
 
 #include "tools.h"
 
-#include <stdlib.h>
 #include <string.h>
 
-unsigned long long day4Solve(const char *data) {
+static unsigned long long countAccessible(const char *data, Arena *scratch) {
   // First pass: count lines
   size_t lineCount = 0;
   const char *p = data;
@@ -23,11 +22,9 @@ unsigned long long day4Solve(const char *data) {
     return 0;
   }
 
-  const char **rows = malloc(lineCount * sizeof(const char *));
-  size_t *lens = malloc(lineCount * sizeof(size_t));
+  const char **rows = arenaAlloc(scratch, lineCount * sizeof(const char *));
+  size_t *lens = arenaAlloc(scratch, lineCount * sizeof(size_t));
   if (!rows || !lens) {
-    free(rows);
-    free(lens);
     return 0;
   }
 
@@ -91,9 +88,14 @@ unsigned long long day4Solve(const char *data) {
     }
   }
 
-  free(rows);
-  free(lens);
+  return accessible;
+}
 
+unsigned long long day4Solve(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long accessible = countAccessible(data, scratch);
+  arenaRelease(scratch, mark);
   return accessible;
 }
 
@@ -102,7 +104,7 @@ typedef struct {
   int y;
 } Point;
 
-unsigned long long day4SolvePartTwo(const char *data) {
+static unsigned long long countRemovable(const char *data, Arena *scratch) {
   // Parse grid into mutable buffer
   size_t lineCount = 0;
   const char *p = data;
@@ -126,11 +128,9 @@ unsigned long long day4SolvePartTwo(const char *data) {
   }
 
   size_t gridSize = lineCount * width;
-  char *grid = malloc(gridSize);
-  unsigned char *adj = malloc(gridSize);
+  char *grid = arenaAlloc(scratch, gridSize);
+  unsigned char *adj = arenaAlloc(scratch, gridSize);
   if (!grid || !adj) {
-    free(grid);
-    free(adj);
     return 0;
   }
   memset(grid, '.', gridSize);
@@ -173,10 +173,8 @@ unsigned long long day4SolvePartTwo(const char *data) {
 
   // Queue for BFS removals
   size_t capacity = gridSize;
-  Point *queue = malloc(capacity * sizeof(Point));
+  Point *queue = arenaAlloc(scratch, capacity * sizeof(Point));
   if (!queue) {
-    free(grid);
-    free(adj);
     return 0;
   }
   size_t qhead = 0, qtail = 0;
@@ -225,9 +223,13 @@ unsigned long long day4SolvePartTwo(const char *data) {
     }
   }
 
-  free(queue);
-  free(grid);
-  free(adj);
+  return removed;
+}
 
+unsigned long long day4SolvePartTwo(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long removed = countRemovable(data, scratch);
+  arenaRelease(scratch, mark);
   return removed;
 }
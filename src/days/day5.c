@@ -1,38 +1,89 @@
 #include "days/day5.h"
 
+#include "fastnum.h"
+#include "tools.h"
+
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
 typedef struct {
   unsigned long long start;
   unsigned long long end;
 } Range;
 
-static int cmpRange(const void *a, const void *b) {
-  const Range *ra = (const Range *)a;
-  const Range *rb = (const Range *)b;
-  if (ra->start < rb->start) {
-    return -1;
-  } else if (ra->start > rb->start) {
-    return 1;
-  } else if (ra->end < rb->end) {
-    return -1;
-  } else if (ra->end > rb->end) {
-    return 1;
+static size_t countRangeLines(const char *p) {
+  size_t lines = 1;
+  while (*p && !(*p == '\n' && *(p + 1) == '\n')) {
+    lines += (*p == '\n');
+    p++;
+  }
+  return lines;
+}
+
+// LSD radix sort of ranges by start, 8 bits per pass, with all histograms
+// gathered in one read and uniform digits skipped. Stable, so equal starts
+// keep input order; the merge below does not care either way. Returns
+// whichever buffer holds the sorted ranges.
+static Range *radixSortRanges(Range *ranges, Range *scratch, size_t count) {
+  size_t hist[8][256];
+  memset(hist, 0, sizeof(hist));
+  for (size_t i = 0; i < count; ++i) {
+    unsigned long long k = ranges[i].start;
+    for (int b = 0; b < 8; ++b) {
+      hist[b][(k >> (8 * b)) & 0xFFu]++;
+    }
+  }
+
+  Range *src = ranges;
+  Range *dst = scratch;
+  for (int b = 0; b < 8; ++b) {
+    size_t *h = hist[b];
+    if (h[(src[0].start >> (8 * b)) & 0xFFu] == count) {
+      continue;
+    }
+    size_t sum = 0;
+    for (int d = 0; d < 256; ++d) {
+      size_t c = h[d];
+      h[d] = sum;
+      sum += c;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      dst[h[(src[i].start >> (8 * b)) & 0xFFu]++] = src[i];
+    }
+    Range *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  return src;
+}
+
+// A range bound in the forms validateDay5 accepts: leading blanks and an
+// optional '+', as strtoull allows.
+static int parseBound(const char **p, const char *end,
+                      unsigned long long *out) {
+  const char *q = fastSkipBlanks(*p, end);
+  if (q < end && *q == '+') {
+    q++;
+  }
+  if (!fastParseU64(&q, end, out)) {
+    return 0;
   }
-  return 0;
+  *p = q;
+  return 1;
 }
 
-static size_t parseRanges(const char *data, Range **out) {
-  size_t capacity = 16;
+static size_t parseRanges(const char *data, const char *dataEnd, Range **out,
+                          Arena *scratch) {
+  size_t capacity = countRangeLines(data);
   size_t count = 0;
-  Range *ranges = malloc(capacity * sizeof(Range));
+  Range *ranges = arenaAlloc(scratch, capacity * sizeof(Range));
   if (!ranges) {
     return 0;
   }
 
   const char *p = data;
-  while (*p) {
+  while (*p && count < capacity) {
     if (*p == '\n') {
       if (*(p + 1) == '\n') {
         p += 2;
@@ -41,77 +92,171 @@ static size_t parseRanges(const char *data, Range **out) {
       p++;
       continue;
     }
-    char *endPtr;
-    unsigned long long start = strtoull(p, &endPtr, 10);
-    if (endPtr == p || *endPtr != '-') {
+    unsigned long long start, end;
+    if (!parseBound(&p, dataEnd, &start)) {
       break;
     }
-    p = endPtr + 1;
-    unsigned long long end = strtoull(p, &endPtr, 10);
-    if (endPtr == p) {
+    p = fastSkipBlanks(p, dataEnd);
+    if (p == dataEnd || *p != '-') {
       break;
     }
-    if (count == capacity) {
-      capacity *= 2;
-      Range *newRanges = realloc(ranges, capacity * sizeof(Range));
-      if (!newRanges) {
-        free(ranges);
-        return 0;
-      }
-      ranges = newRanges;
+    p++;
+    if (!parseBound(&p, dataEnd, &end)) {
+      break;
     }
     ranges[count++] = (Range){start, end};
-    while (*endPtr == ' ' || *endPtr == '\t') {
-      endPtr++;
+    while (*p == ' ' || *p == '\t') {
+      p++;
     }
-    if (*endPtr == '\n') {
-      endPtr++;
+    if (*p == '\n') {
+      p++;
     }
-    p = endPtr;
   }
 
-  qsort(ranges, count, sizeof(Range), cmpRange);
+  *out = ranges;
+  if (count == 0) {
+    return 0;
+  }
+
+  // The sort buffer is only needed until the merge; give it back after.
+  ArenaMark mark = arenaMark(scratch);
+  Range *buffer = arenaAlloc(scratch, count * sizeof(Range));
+  if (!buffer) {
+    *out = NULL;
+    return 0;
+  }
+  const Range *sorted = radixSortRanges(ranges, buffer, count);
 
-  // Merge overlapping
+  // Merge overlapping. When the sort finished in the scratch buffer this
+  // pass doubles as the copy back into `ranges`.
   size_t write = 0;
   for (size_t i = 0; i < count; ++i) {
-    if (write == 0) {
-      ranges[write++] = ranges[i];
-    } else {
-      if (ranges[i].start <= ranges[write - 1].end + 1) {
-        if (ranges[i].end > ranges[write - 1].end) {
-          ranges[write - 1].end = ranges[i].end;
-        }
-      } else {
-        ranges[write++] = ranges[i];
+    Range r = sorted[i];
+    if (write > 0 && r.start <= ranges[write - 1].end + 1) {
+      if (r.end > ranges[write - 1].end) {
+        ranges[write - 1].end = r.end;
       }
+    } else {
+      ranges[write++] = r;
     }
   }
 
-  *out = ranges;
+  arenaRelease(scratch, mark);
   return write;
 }
 
-static int inRanges(const Range *ranges, size_t count,
-                    unsigned long long value) {
-  size_t lo = 0;
-  size_t hi = count;
-  while (lo < hi) {
-    size_t mid = lo + (hi - lo) / 2;
-    if (value < ranges[mid].start) {
-      hi = mid;
-    } else if (value > ranges[mid].end) {
-      lo = mid + 1;
-    } else {
-      return 1;
+enum {
+  // IDs resolved per interleaved descent; enough independent loads in
+  // flight to hide the miss latency of the lower tree levels.
+  D5_BATCH = 16,
+  D5_LINE_KEYS = 64 / sizeof(unsigned long long),
+  // Minimum IDs per merged range before sort-merge join is considered.
+  D5_JOIN_MIN_RATIO = 8
+};
+
+// Merged ranges in Eytzinger (BFS) order, 1-based and padded to a complete
+// tree so every lookup descends exactly `levels` steps. The descent key is
+// `end`: merged ranges are disjoint, so ends are sorted as well and the first
+// range with end >= id is the only one that can contain it.
+typedef struct {
+  unsigned long long *ends;
+  unsigned long long *starts;
+  size_t size;
+  int levels;
+} RangeIndex;
+
+static size_t rangeIndexFill(RangeIndex *idx, const Range *ranges,
+                             size_t count, size_t next, size_t k) {
+  if (k > idx->size) {
+    return next;
+  }
+  next = rangeIndexFill(idx, ranges, count, next, 2 * k);
+  // Padding repeats the last range; lower-bound search always lands on the
+  // real copy first because it precedes the pads in sorted order.
+  const Range *r = &ranges[next < count ? next : count - 1];
+  idx->ends[k] = r->end;
+  idx->starts[k] = r->start;
+  next++;
+  return rangeIndexFill(idx, ranges, count, next, 2 * k + 1);
+}
+
+static int rangeIndexBuild(RangeIndex *idx, const Range *ranges,
+                           size_t count, Arena *scratch) {
+  idx->levels = 0;
+  idx->size = 0;
+  while (idx->size < count) {
+    idx->levels++;
+    idx->size = idx->size * 2 + 1;
+  }
+
+  // The 8 descendants three levels below node k sit in slots 8k..8k+7, which
+  // is exactly one cache line once the arrays are line-aligned.
+  size_t slots = (idx->size + D5_LINE_KEYS) & ~(size_t)(D5_LINE_KEYS - 1);
+  idx->ends = arenaAllocAligned(scratch, 2 * slots * sizeof(unsigned long long),
+                                64);
+  if (!idx->ends) {
+    return 0;
+  }
+  idx->starts = idx->ends + slots;
+  // Slot 0 is where a failed search ends up; make it reject every value.
+  idx->ends[0] = 0;
+  idx->starts[0] = 1;
+  if (count > 0) {
+    rangeIndexFill(idx, ranges, count, 0, 1);
+  }
+  return 1;
+}
+
+static inline size_t rangeIndexPrefetchSlot(const RangeIndex *idx, size_t k) {
+  size_t slot = k * D5_LINE_KEYS;
+  return slot <= idx->size ? slot : 0;
+}
+
+static inline int rangeIndexResolve(const RangeIndex *idx, size_t k,
+                                    unsigned long long value) {
+  // Drop the trailing right turns plus the final left turn to recover the
+  // lower-bound node; a search that only turned right yields slot 0.
+  k >>= __builtin_ffsll((long long)~k);
+  return (idx->starts[k] <= value) & (value <= idx->ends[k]);
+}
+
+static int rangeIndexContains(const RangeIndex *idx,
+                              unsigned long long value) {
+  size_t k = 1;
+  for (int level = 0; level < idx->levels; ++level) {
+    __builtin_prefetch(idx->ends + rangeIndexPrefetchSlot(idx, k));
+    k = 2 * k + (idx->ends[k] < value);
+  }
+  return rangeIndexResolve(idx, k, value);
+}
+
+// Resolves up to D5_BATCH IDs with interleaved branch-free descents and
+// stores one membership flag per ID. Returns the number of hits.
+static size_t rangeIndexLookupBatch(const RangeIndex *idx,
+                                    const unsigned long long *values,
+                                    size_t count, unsigned char *hits) {
+  size_t k[D5_BATCH];
+  for (size_t i = 0; i < count; ++i) {
+    k[i] = 1;
+  }
+  for (int level = 0; level < idx->levels; ++level) {
+    for (size_t i = 0; i < count; ++i) {
+      __builtin_prefetch(idx->ends + rangeIndexPrefetchSlot(idx, k[i]));
+      k[i] = 2 * k[i] + (idx->ends[k[i]] < values[i]);
     }
   }
-  return 0;
+  size_t found = 0;
+  for (size_t i = 0; i < count; ++i) {
+    hits[i] = (unsigned char)rangeIndexResolve(idx, k[i], values[i]);
+    found += hits[i];
+  }
+  return found;
 }
 
-static Range *getMergedRanges(const char *data, size_t *outCount) {
+static Range *getMergedRanges(const char *data, const char *end,
+                              size_t *outCount, Arena *scratch) {
   Range *ranges = NULL;
-  size_t rangeCount = parseRanges(data, &ranges);
+  size_t rangeCount = parseRanges(data, end, &ranges, scratch);
   if (!ranges) {
     return NULL;
   }
@@ -119,9 +264,124 @@ static Range *getMergedRanges(const char *data, size_t *outCount) {
   return ranges;
 }
 
-unsigned long long day5Solve(const char *data) {
+// The IDs are one whitespace-separated list of numbers.
+static unsigned long long *parseIds(const char *p, const char *end,
+                                    size_t *outCount,
+                                    unsigned long long *outMax,
+                                    Arena *scratch) {
+  U64Vec ids = {0};
+  if (!U64VecReserve(scratch, &ids, 64) ||
+      !fastParseU64List(p, end, scratch, &ids)) {
+    return NULL;
+  }
+  unsigned long long maxId = 0;
+  for (size_t i = 0; i < ids.count; ++i) {
+    if (ids.items[i] > maxId) {
+      maxId = ids.items[i];
+    }
+  }
+  *outCount = ids.count;
+  *outMax = maxId;
+  return ids.items;
+}
+
+// LSD radix sort on 8-bit digits. All eight histograms come from one read of
+// the keys, and digits where every key agrees are skipped, so small IDs cost
+// only as many scatter passes as they have significant bytes. Returns
+// whichever of the two buffers ends up holding the sorted keys.
+static unsigned long long *radixSortIds(unsigned long long *keys,
+                                        unsigned long long *scratch,
+                                        size_t count) {
+  size_t hist[8][256];
+  memset(hist, 0, sizeof(hist));
+  for (size_t i = 0; i < count; ++i) {
+    unsigned long long k = keys[i];
+    for (int b = 0; b < 8; ++b) {
+      hist[b][(k >> (8 * b)) & 0xFFu]++;
+    }
+  }
+
+  unsigned long long *src = keys;
+  unsigned long long *dst = scratch;
+  for (int b = 0; b < 8; ++b) {
+    size_t *h = hist[b];
+    if (h[(src[0] >> (8 * b)) & 0xFFu] == count) {
+      continue;
+    }
+    size_t sum = 0;
+    for (int d = 0; d < 256; ++d) {
+      size_t c = h[d];
+      h[d] = sum;
+      sum += c;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      unsigned long long k = src[i];
+      dst[h[(k >> (8 * b)) & 0xFFu]++] = k;
+    }
+    unsigned long long *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  return src;
+}
+
+static unsigned long long countFreshSorted(const Range *ranges,
+                                           size_t rangeCount,
+                                           const unsigned long long *ids,
+                                           size_t idCount) {
+  unsigned long long fresh = 0;
+  size_t r = 0;
+  for (size_t i = 0; i < idCount && r < rangeCount; ++i) {
+    unsigned long long id = ids[i];
+    while (r < rangeCount && ranges[r].end < id) {
+      r++;
+    }
+    fresh += (unsigned long long)(r < rangeCount && ranges[r].start <= id);
+  }
+  return fresh;
+}
+
+static unsigned long long countFreshIndexed(const RangeIndex *index,
+                                            const unsigned long long *ids,
+                                            size_t idCount) {
+  unsigned long long fresh = 0;
+  unsigned char hits[D5_BATCH];
+  size_t i = 0;
+  for (; i + D5_BATCH <= idCount; i += D5_BATCH) {
+    fresh += rangeIndexLookupBatch(index, ids + i, D5_BATCH, hits);
+  }
+  for (; i < idCount; ++i) {
+    fresh += (unsigned long long)rangeIndexContains(index, ids[i]);
+  }
+  return fresh;
+}
+
+// Sort-merge pays ~2 memory touches per significant ID byte plus one linear
+// sweep over the ranges; per-ID search pays one dependent load per tree
+// level. Only switch when IDs dominate, so the sort amortises.
+static int preferSortMerge(size_t rangeCount, size_t idCount,
+                           unsigned long long maxId) {
+  if (idCount < (size_t)D5_JOIN_MIN_RATIO * rangeCount) {
+    return 0;
+  }
+  int passes = 0;
+  while (maxId > 0) {
+    passes++;
+    maxId >>= 8;
+  }
+  int levels = 0;
+  for (size_t n = 0; n < rangeCount; n = n * 2 + 1) {
+    levels++;
+  }
+  return (unsigned long long)idCount * (unsigned long long)(2 * passes + 1) +
+             rangeCount <
+         (unsigned long long)idCount * (unsigned long long)levels;
+}
+
+static unsigned long long countFresh(const char *data, Arena *scratch) {
+  const char *end = data + strlen(data);
   size_t rangeCount = 0;
-  Range *ranges = getMergedRanges(data, &rangeCount);
+  Range *ranges = getMergedRanges(data, end, &rangeCount, scratch);
   if (!ranges) {
     return 0;
   }
@@ -134,42 +394,45 @@ unsigned long long day5Solve(const char *data) {
     p += 2;
   }
 
-  unsigned long long fresh = 0;
-  while (*p) {
-    while (*p == '\n') {
-      p++;
-    }
-    if (*p == '\0') {
-      break;
-    }
-    char *endPtr;
-    unsigned long long id = strtoull(p, &endPtr, 10);
-    if (endPtr == p) {
-      break;
-    }
-    if (inRanges(ranges, rangeCount, id)) {
-      fresh++;
-    }
-    p = endPtr;
-    while (*p == ' ' || *p == '\t') {
-      p++;
-    }
-    while (*p == ' ' || *p == '\t') {
-      p++;
-    }
-    if (*p == '\n') {
-      p++;
+  size_t idCount = 0;
+  unsigned long long maxId = 0;
+  unsigned long long *ids = parseIds(p, end, &idCount, &maxId, scratch);
+  if (!ids) {
+    return 0;
+  }
+
+  if (idCount > 0 && preferSortMerge(rangeCount, idCount, maxId)) {
+    unsigned long long *buffer =
+        arenaAlloc(scratch, idCount * sizeof(unsigned long long));
+    if (!buffer) {
+      return 0;
     }
+    const unsigned long long *sorted = radixSortIds(ids, buffer, idCount);
+    return countFreshSorted(ranges, rangeCount, sorted, idCount);
   }
+  RangeIndex index;
+  if (!rangeIndexBuild(&index, ranges, rangeCount, scratch)) {
+    return 0;
+  }
+  return countFreshIndexed(&index, ids, idCount);
+}
 
-  free(ranges);
+unsigned long long day5Solve(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long fresh = countFresh(data, scratch);
+  arenaRelease(scratch, mark);
   return fresh;
 }
 
 unsigned long long day5SolvePartTwo(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
   size_t rangeCount = 0;
-  Range *ranges = getMergedRanges(data, &rangeCount);
+  Range *ranges =
+      getMergedRanges(data, data + strlen(data), &rangeCount, scratch);
   if (!ranges) {
+    arenaRelease(scratch, mark);
     return 0;
   }
 
@@ -180,6 +443,6 @@ unsigned long long day5SolvePartTwo(const char *data) {
     }
   }
 
-  free(ranges);
+  arenaRelease(scratch, mark);
   return total;
 }
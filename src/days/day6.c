@@ -3,49 +3,38 @@
 #include "tools.h"
 
 #include <stddef.h>
-#include <stdlib.h>
 #include <string.h>
 
+ARENA_VEC(NumVec, unsigned long long)
+
 typedef struct {
   char op;
-  unsigned long long *nums;
-  size_t count;
-  size_t capacity;
+  NumVec nums;
 } Problem;
 
-static void problemAddNum(Problem *p, unsigned long long v) {
-  if (p->count == p->capacity) {
-    size_t newCap = p->capacity ? p->capacity * 2 : 4;
-    unsigned long long *nn =
-        realloc(p->nums, newCap * sizeof(unsigned long long));
-    if (!nn) {
-      return;
-    }
-    p->nums = nn;
-    p->capacity = newCap;
-  }
-  p->nums[p->count++] = v;
-}
-
 static unsigned long long problemEval(const Problem *p) {
-  if (p->count == 0) {
+  const NumVec *nums = &p->nums;
+  if (nums->count == 0) {
     return 0;
   }
   if (p->op == '+') {
     unsigned long long s = 0;
-    for (size_t i = 0; i < p->count; ++i) {
-      s += p->nums[i];
+    for (size_t i = 0; i < nums->count; ++i) {
+      s += nums->items[i];
     }
     return s;
   }
   unsigned long long mul = 1;
-  for (size_t i = 0; i < p->count; ++i) {
-    mul *= p->nums[i];
+  for (size_t i = 0; i < nums->count; ++i) {
+    mul *= nums->items[i];
   }
   return mul;
 }
 
-unsigned long long day6Solve(const char *data) {
+// Pads every line to the widest one and finds the operator row (the last
+// row with a non-space character). Returns NULL for empty or blank input.
+static char **loadGrid(const char *data, Arena *scratch, size_t *outWidth,
+                       long *outOpRow) {
   // Count lines and width
   size_t lines = 0;
   size_t width = 0;
@@ -65,24 +54,17 @@ unsigned long long day6Solve(const char *data) {
     }
   }
   if (lines == 0 || width == 0) {
-    return 0;
+    return NULL;
   }
 
-  // Pad lines to width
-  char **grid = malloc(lines * sizeof(char *));
-  if (!grid) {
-    return 0;
+  char **grid = arenaAlloc(scratch, lines * sizeof(char *));
+  char *cells = arenaAlloc(scratch, lines * width);
+  if (!grid || !cells) {
+    return NULL;
   }
   p = data;
   for (size_t r = 0; r < lines; ++r) {
-    grid[r] = malloc(width);
-    if (!grid[r]) {
-      for (size_t k = 0; k < r; ++k) {
-        free(grid[k]);
-      }
-      free(grid);
-      return 0;
-    }
+    grid[r] = cells + r * width;
     size_t len = 0;
     while (p[len] && p[len] != '\n') {
       grid[r][len] = p[len];
@@ -97,7 +79,6 @@ unsigned long long day6Solve(const char *data) {
     }
   }
 
-  // Find last non-empty row (any non-space char)
   long opRow = -1;
   for (long r = (long)lines - 1; r >= 0; --r) {
     int has = 0;
@@ -113,10 +94,18 @@ unsigned long long day6Solve(const char *data) {
     }
   }
   if (opRow < 0) {
-    for (size_t r = 0; r < lines; ++r) {
-      free(grid[r]);
-    }
-    free(grid);
+    return NULL;
+  }
+  *outWidth = width;
+  *outOpRow = opRow;
+  return grid;
+}
+
+static unsigned long long sumRowProblems(const char *data, Arena *scratch) {
+  size_t width;
+  long opRow;
+  char **grid = loadGrid(data, scratch, &width, &opRow);
+  if (!grid) {
     return 0;
   }
 
@@ -158,7 +147,9 @@ unsigned long long day6Solve(const char *data) {
       end++;
     }
 
-    Problem prob = {.op = '+', .nums = NULL, .count = 0, .capacity = 0};
+    // Each problem's numbers are dropped once it is evaluated.
+    ArenaMark mark = arenaMark(scratch);
+    Problem prob = {.op = '+'};
 
     // Operator at opRow in this column span
     for (size_t c = start; c < end; ++c) {
@@ -185,95 +176,26 @@ unsigned long long day6Solve(const char *data) {
         val = val * 10ULL + (unsigned long long)(row[c] - '0');
         c++;
       }
-      problemAddNum(&prob, val);
+      NumVecPush(scratch, &prob.nums, val);
     }
 
     total += problemEval(&prob);
-    free(prob.nums);
+    arenaRelease(scratch, mark);
 
     col = end + 1;
   }
 
-  for (size_t r = 0; r < lines; ++r) {
-    free(grid[r]);
-  }
-  free(grid);
-
   return total;
 }
 
-unsigned long long day6SolvePartTwo(const char *data) {
-  // Count lines and width
-  size_t lines = 0;
-  size_t width = 0;
-  const char *p = data;
-  while (*p) {
-    size_t len = 0;
-    while (p[len] && p[len] != '\n') {
-      len++;
-    }
-    if (len > width) {
-      width = len;
-    }
-    lines++;
-    p += len;
-    if (*p == '\n') {
-      p++;
-    }
-  }
-  if (lines == 0 || width == 0) {
-    return 0;
-  }
-
-  char **grid = malloc(lines * sizeof(char *));
+static unsigned long long sumColumnProblems(const char *data,
+                                            Arena *scratch) {
+  size_t width;
+  long opRow;
+  char **grid = loadGrid(data, scratch, &width, &opRow);
   if (!grid) {
     return 0;
   }
-  p = data;
-  for (size_t r = 0; r < lines; ++r) {
-    grid[r] = malloc(width);
-    if (!grid[r]) {
-      for (size_t k = 0; k < r; ++k) {
-        free(grid[k]);
-      }
-      free(grid);
-      return 0;
-    }
-    size_t len = 0;
-    while (p[len] && p[len] != '\n') {
-      grid[r][len] = p[len];
-      len++;
-    }
-    for (size_t c = len; c < width; ++c) {
-      grid[r][c] = ' ';
-    }
-    p += len;
-    if (*p == '\n') {
-      p++;
-    }
-  }
-
-  long opRow = -1;
-  for (long r = (long)lines - 1; r >= 0; --r) {
-    int has = 0;
-    for (size_t c = 0; c < width; ++c) {
-      if (grid[r][c] != ' ') {
-        has = 1;
-        break;
-      }
-    }
-    if (has) {
-      opRow = r;
-      break;
-    }
-  }
-  if (opRow < 0) {
-    for (size_t r = 0; r < lines; ++r) {
-      free(grid[r]);
-    }
-    free(grid);
-    return 0;
-  }
 
   // Process columns right-to-left
   unsigned long long total = 0;
@@ -313,7 +235,9 @@ unsigned long long day6SolvePartTwo(const char *data) {
     }
     start++; // move to first non-empty column
 
-    Problem prob = {.op = '+', .nums = NULL, .count = 0, .capacity = 0};
+    // Each problem's numbers are dropped once it is evaluated.
+    ArenaMark mark = arenaMark(scratch);
+    Problem prob = {.op = '+'};
     // Operator from opRow
     for (long c = start; c <= end; ++c) {
       char ch = grid[opRow][(size_t)c];
@@ -335,20 +259,31 @@ unsigned long long day6SolvePartTwo(const char *data) {
         }
       }
       if (hasDigit) {
-        problemAddNum(&prob, val);
+        NumVecPush(scratch, &prob.nums, val);
       }
     }
 
     total += problemEval(&prob);
-    free(prob.nums);
+    arenaRelease(scratch, mark);
 
     col = start - 2; // move left past spacer
   }
 
-  for (size_t r = 0; r < lines; ++r) {
-    free(grid[r]);
-  }
-  free(grid);
+  return total;
+}
 
+unsigned long long day6Solve(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long total = sumRowProblems(data, scratch);
+  arenaRelease(scratch, mark);
+  return total;
+}
+
+unsigned long long day6SolvePartTwo(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long total = sumColumnProblems(data, scratch);
+  arenaRelease(scratch, mark);
   return total;
 }
@@ -1,10 +1,20 @@
 #include "days/day7.h"
 
+#include "tools.h"
+
 #include <stddef.h>
-#include <stdlib.h>
 
-unsigned long long day7Solve(const char *data) {
-  // Parse grid, find S
+typedef struct {
+  char **rows;
+  size_t lines;
+  size_t width;
+  size_t sRow;
+  size_t sCol;
+} Grid7;
+
+// Pads every line to the widest one with '.' and locates S. Returns 0 for
+// empty input or when there is no S.
+static int loadGrid(const char *data, Arena *scratch, Grid7 *grid) {
   size_t lines = 0;
   size_t width = 0;
   const char *p = data;
@@ -26,25 +36,19 @@ unsigned long long day7Solve(const char *data) {
     return 0;
   }
 
-  char **grid = malloc(lines * sizeof(char *));
-  if (!grid) {
+  char **rows = arenaAlloc(scratch, lines * sizeof(char *));
+  char *cells = arenaAlloc(scratch, lines * width);
+  if (!rows || !cells) {
     return 0;
   }
   p = data;
   size_t sRow = (size_t)-1;
   size_t sCol = (size_t)-1;
   for (size_t r = 0; r < lines; ++r) {
-    grid[r] = malloc(width);
-    if (!grid[r]) {
-      for (size_t k = 0; k < r; ++k) {
-        free(grid[k]);
-      }
-      free(grid);
-      return 0;
-    }
+    rows[r] = cells + r * width;
     size_t len = 0;
     while (p[len] && p[len] != '\n') {
-      grid[r][len] = p[len];
+      rows[r][len] = p[len];
       if (p[len] == 'S') {
         sRow = r;
         sCol = len;
@@ -52,31 +56,35 @@ unsigned long long day7Solve(const char *data) {
       len++;
     }
     for (size_t c = len; c < width; ++c) {
-      grid[r][c] = '.';
+      rows[r][c] = '.';
     }
     p += len;
     if (*p == '\n') {
       p++;
     }
   }
-
   if (sRow == (size_t)-1) {
-    for (size_t r = 0; r < lines; ++r) {
-      free(grid[r]);
-    }
-    free(grid);
     return 0;
   }
 
-  unsigned char *curr = calloc(width, 1);
-  unsigned char *next = calloc(width, 1);
+  *grid = (Grid7){rows, lines, width, sRow, sCol};
+  return 1;
+}
+
+static unsigned long long countSplits(const char *data, Arena *scratch) {
+  Grid7 g;
+  if (!loadGrid(data, scratch, &g)) {
+    return 0;
+  }
+  char **grid = g.rows;
+  size_t lines = g.lines;
+  size_t width = g.width;
+  size_t sRow = g.sRow;
+  size_t sCol = g.sCol;
+
+  unsigned char *curr = arenaAllocZero(scratch, width, 1);
+  unsigned char *next = arenaAllocZero(scratch, width, 1);
   if (!curr || !next) {
-    free(curr);
-    free(next);
-    for (size_t r = 0; r < lines; ++r) {
-      free(grid[r]);
-    }
-    free(grid);
     return 0;
   }
 
@@ -108,90 +116,25 @@ unsigned long long day7Solve(const char *data) {
     }
   }
 
-  free(curr);
-  free(next);
-  for (size_t r = 0; r < lines; ++r) {
-    free(grid[r]);
-  }
-  free(grid);
-
   return splits;
 }
 
-unsigned long long day7SolvePartTwo(const char *data) {
-  // Parse grid, find S
-  size_t lines = 0;
-  size_t width = 0;
-  const char *p = data;
-  while (*p) {
-    size_t len = 0;
-    while (p[len] && p[len] != '\n') {
-      len++;
-    }
-    if (len > width) {
-      width = len;
-    }
-    lines++;
-    p += len;
-    if (*p == '\n') {
-      p++;
-    }
-  }
-  if (lines == 0 || width == 0) {
+static unsigned long long countTimelines(const char *data, Arena *scratch) {
+  Grid7 g;
+  if (!loadGrid(data, scratch, &g)) {
     return 0;
   }
+  char **grid = g.rows;
+  size_t lines = g.lines;
+  size_t width = g.width;
+  size_t sRow = g.sRow;
+  size_t sCol = g.sCol;
 
-  char **grid = malloc(lines * sizeof(char *));
-  if (!grid) {
-    return 0;
-  }
-  p = data;
-  size_t sRow = (size_t)-1;
-  size_t sCol = (size_t)-1;
-  for (size_t r = 0; r < lines; ++r) {
-    grid[r] = malloc(width);
-    if (!grid[r]) {
-      for (size_t k = 0; k < r; ++k) {
-        free(grid[k]);
-      }
-      free(grid);
-      return 0;
-    }
-    size_t len = 0;
-    while (p[len] && p[len] != '\n') {
-      grid[r][len] = p[len];
-      if (p[len] == 'S') {
-        sRow = r;
-        sCol = len;
-      }
-      len++;
-    }
-    for (size_t c = len; c < width; ++c) {
-      grid[r][c] = '.';
-    }
-    p += len;
-    if (*p == '\n') {
-      p++;
-    }
-  }
-
-  if (sRow == (size_t)-1) {
-    for (size_t r = 0; r < lines; ++r) {
-      free(grid[r]);
-    }
-    free(grid);
-    return 0;
-  }
-
-  unsigned long long *curr = calloc(width, sizeof(unsigned long long));
-  unsigned long long *next = calloc(width, sizeof(unsigned long long));
+  unsigned long long *curr =
+      arenaAllocZero(scratch, width, sizeof(unsigned long long));
+  unsigned long long *next =
+      arenaAllocZero(scratch, width, sizeof(unsigned long long));
   if (!curr || !next) {
-    free(curr);
-    free(next);
-    for (size_t r = 0; r < lines; ++r) {
-      free(grid[r]);
-    }
-    free(grid);
     return 0;
   }
 
@@ -226,12 +169,21 @@ unsigned long long day7SolvePartTwo(const char *data) {
     total += curr[c];
   }
 
-  free(curr);
-  free(next);
-  for (size_t r = 0; r < lines; ++r) {
-    free(grid[r]);
-  }
-  free(grid);
+  return total;
+}
 
+unsigned long long day7Solve(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long splits = countSplits(data, scratch);
+  arenaRelease(scratch, mark);
+  return splits;
+}
+
+unsigned long long day7SolvePartTwo(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long total = countTimelines(data, scratch);
+  arenaRelease(scratch, mark);
   return total;
 }
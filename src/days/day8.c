@@ -1,5 +1,9 @@
 #include "days/day8.h"
 
+#include "fastnum.h"
+#include "stats.h"
+#include "tools.h"
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -15,10 +19,13 @@ typedef struct {
   int b;
 } Edge;
 
+ARENA_VEC(EdgeVec, Edge)
+ARENA_VEC(Point3Vec, Point3)
+
+// Max-heap by dist over a growable edge array.
 typedef struct {
-  Edge *data;
-  size_t size;
-  size_t capacity;
+  EdgeVec edges;
+  Arena *arena;
 } MaxHeap;
 
 static void heapSwap(Edge *a, Edge *b) {
@@ -28,49 +35,46 @@ static void heapSwap(Edge *a, Edge *b) {
 }
 
 static void heapPush(MaxHeap *h, Edge e) {
-  if (h->size == h->capacity) {
-    size_t newCap = h->capacity ? h->capacity * 2 : 16;
-    Edge *n = realloc(h->data, newCap * sizeof(Edge));
-    if (!n) {
-      return;
-    }
-    h->data = n;
-    h->capacity = newCap;
+  if (!EdgeVecPush(h->arena, &h->edges, e)) {
+    return;
   }
-  size_t idx = h->size++;
-  h->data[idx] = e;
+  Edge *data = h->edges.items;
+  size_t idx = h->edges.count - 1;
   // sift up for max-heap by dist
   while (idx > 0) {
     size_t parent = (idx - 1) / 2;
-    if (h->data[parent].dist >= h->data[idx].dist) {
+    if (data[parent].dist >= data[idx].dist) {
       break;
     }
-    heapSwap(&h->data[parent], &h->data[idx]);
+    heapSwap(&data[parent], &data[idx]);
     idx = parent;
   }
 }
 
 static void heapReplaceRoot(MaxHeap *h, Edge e) {
-  if (h->size == 0) {
+  if (h->edges.count == 0) {
     heapPush(h, e);
     return;
   }
-  h->data[0] = e;
+  STAT_INC(D8_HEAP_REPLACEMENTS);
+  Edge *data = h->edges.items;
+  size_t size = h->edges.count;
+  data[0] = e;
   size_t idx = 0;
   while (1) {
     size_t l = idx * 2 + 1;
     size_t r = idx * 2 + 2;
     size_t largest = idx;
-    if (l < h->size && h->data[l].dist > h->data[largest].dist) {
+    if (l < size && data[l].dist > data[largest].dist) {
       largest = l;
     }
-    if (r < h->size && h->data[r].dist > h->data[largest].dist) {
+    if (r < size && data[r].dist > data[largest].dist) {
       largest = r;
     }
     if (largest == idx) {
       break;
     }
-    heapSwap(&h->data[idx], &h->data[largest]);
+    heapSwap(&data[idx], &data[largest]);
     idx = largest;
   }
 }
@@ -103,40 +107,39 @@ static void unionSet(int *parent, int *size, int a, int b) {
   size[a] += size[b];
 }
 
-unsigned long long day8Solve(const char *data) {
-  // Parse points
-  size_t capacity = 32;
-  size_t count = 0;
-  Point3 *pts = malloc(capacity * sizeof(Point3));
+// Parses "x,y,z" lines. Returns NULL when there are none.
+static Point3 *parsePoints(const char *data, Arena *scratch,
+                           size_t *outCount) {
+  Point3Vec pts = {0};
+  if (!Point3VecReserve(scratch, &pts, 32)) {
+    return NULL;
+  }
   const char *p = data;
-  while (*p) {
-    while (*p == '\n' || *p == '\r') p++;
-    if (*p == '\0') break;
-    char *end;
-    int x = (int)strtol(p, &end, 10);
-    if (end == p || *end != ',') break;
-    p = end + 1;
-    int y = (int)strtol(p, &end, 10);
-    if (end == p || *end != ',') break;
-    p = end + 1;
-    int z = (int)strtol(p, &end, 10);
-    if (end == p) break;
-    if (count == capacity) {
-      capacity *= 2;
-      Point3 *n = realloc(pts, capacity * sizeof(Point3));
-      if (!n) {
-        free(pts);
-        return 0;
-      }
-      pts = n;
+  const char *end = data + strlen(data);
+  while (p < end) {
+    while (p < end && (*p == '\n' || *p == '\r')) p++;
+    if (p == end) break;
+    long long x, y, z;
+    if (!fastParseI64(&p, end, &x) || p == end || *p++ != ',') break;
+    if (!fastParseI64(&p, end, &y) || p == end || *p++ != ',') break;
+    if (!fastParseI64(&p, end, &z)) break;
+    if (!Point3VecPush(scratch, &pts, (Point3){(int)x, (int)y, (int)z})) {
+      return NULL;
     }
-    pts[count++] = (Point3){x, y, z};
-    p = end;
-    while (*p == ' ' || *p == '\t') p++;
-    if (*p == '\n') p++;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p < end && *p == '\n') p++;
+  }
+  if (pts.count == 0) {
+    return NULL;
   }
-  if (count == 0) {
-    free(pts);
+  *outCount = pts.count;
+  return pts.items;
+}
+
+static unsigned long long largestCircuits(const char *data, Arena *scratch) {
+  size_t count = 0;
+  Point3 *pts = parsePoints(data, scratch, &count);
+  if (!pts) {
     return 0;
   }
 
@@ -144,7 +147,11 @@ unsigned long long day8Solve(const char *data) {
   size_t totalPairs = count * (count - 1) / 2;
   if (limit > totalPairs) limit = totalPairs;
 
-  MaxHeap heap = {.data = NULL, .size = 0, .capacity = 0};
+  // The heap never holds more than limit edges, so it never grows.
+  MaxHeap heap = {.arena = scratch};
+  if (!EdgeVecReserve(scratch, &heap.edges, limit)) {
+    return 0;
+  }
 
   for (size_t i = 0; i < count; ++i) {
     for (size_t j = i + 1; j < count; ++j) {
@@ -153,26 +160,22 @@ unsigned long long day8Solve(const char *data) {
       long dz = (long)pts[i].z - (long)pts[j].z;
       unsigned long long dist = (unsigned long long)(dx * dx + dy * dy + dz * dz);
       Edge e = {.dist = dist, .a = (int)i, .b = (int)j};
-      if (heap.size < limit) {
+      if (heap.edges.count < limit) {
         heapPush(&heap, e);
-      } else if (dist < heap.data[0].dist) {
+      } else if (dist < heap.edges.items[0].dist) {
         heapReplaceRoot(&heap, e);
       }
     }
   }
 
   // Gather edges
-  Edge *edges = heap.data;
-  size_t edgeCount = heap.size;
+  Edge *edges = heap.edges.items;
+  size_t edgeCount = heap.edges.count;
   qsort(edges, edgeCount, sizeof(Edge), cmpEdge);
 
-  int *parent = malloc(count * sizeof(int));
-  int *sizes = malloc(count * sizeof(int));
+  int *parent = arenaAlloc(scratch, count * sizeof(int));
+  int *sizes = arenaAlloc(scratch, count * sizeof(int));
   if (!parent || !sizes) {
-    free(parent);
-    free(sizes);
-    free(edges);
-    free(pts);
     return 0;
   }
   for (size_t i = 0; i < count; ++i) {
@@ -204,60 +207,22 @@ unsigned long long day8Solve(const char *data) {
     }
   }
 
-  unsigned long long result = top1 * top2 * top3;
-
-  free(parent);
-  free(sizes);
-  free(edges);
-  free(pts);
-  return result;
+  return top1 * top2 * top3;
 }
 
-unsigned long long day8SolvePartTwo(const char *data) {
-  size_t capacity = 32;
+static unsigned long long lastJunction(const char *data, Arena *scratch) {
   size_t count = 0;
-  Point3 *pts = malloc(capacity * sizeof(Point3));
-  const char *p = data;
-  while (*p) {
-    while (*p == '\n' || *p == '\r') p++;
-    if (*p == '\0') break;
-    char *end;
-    int x = (int)strtol(p, &end, 10);
-    if (end == p || *end != ',') break;
-    p = end + 1;
-    int y = (int)strtol(p, &end, 10);
-    if (end == p || *end != ',') break;
-    p = end + 1;
-    int z = (int)strtol(p, &end, 10);
-    if (end == p) break;
-    if (count == capacity) {
-      capacity *= 2;
-      Point3 *n = realloc(pts, capacity * sizeof(Point3));
-      if (!n) {
-        free(pts);
-        return 0;
-      }
-      pts = n;
-    }
-    pts[count++] = (Point3){x, y, z};
-    p = end;
-    while (*p == ' ' || *p == '\t') p++;
-    if (*p == '\n') p++;
-  }
-  if (count == 0) {
-    free(pts);
+  Point3 *pts = parsePoints(data, scratch, &count);
+  if (!pts) {
     return 0;
   }
 
   // Prim's algorithm with O(n^2) time, O(n) memory
-  unsigned long long *best = malloc(count * sizeof(unsigned long long));
-  int *parent = malloc(count * sizeof(int));
-  char *inTree = calloc(count, 1);
+  unsigned long long *best =
+      arenaAlloc(scratch, count * sizeof(unsigned long long));
+  int *parent = arenaAlloc(scratch, count * sizeof(int));
+  char *inTree = arenaAllocZero(scratch, count, 1);
   if (!best || !parent || !inTree) {
-    free(best);
-    free(parent);
-    free(inTree);
-    free(pts);
     return 0;
   }
 
@@ -303,12 +268,21 @@ unsigned long long day8SolvePartTwo(const char *data) {
     }
   }
 
-  unsigned long long answer =
-      (unsigned long long)pts[maxA].x * (unsigned long long)pts[maxB].x;
+  return (unsigned long long)pts[maxA].x * (unsigned long long)pts[maxB].x;
+}
+
+unsigned long long day8Solve(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long result = largestCircuits(data, scratch);
+  arenaRelease(scratch, mark);
+  return result;
+}
 
-  free(best);
-  free(parent);
-  free(inTree);
-  free(pts);
+unsigned long long day8SolvePartTwo(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long answer = lastJunction(data, scratch);
+  arenaRelease(scratch, mark);
   return answer;
 }
@@ -1,5 +1,8 @@
 #include "days/day9.h"
 
+#include "fastnum.h"
+#include "tools.h"
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -13,17 +16,9 @@ typedef struct {
   int b;
 } Interval;
 
-typedef struct {
-  Interval *arr;
-  int count;
-  int cap;
-} RowIntervals;
-
-typedef struct {
-  int *arr;
-  int count;
-  int cap;
-} IntList;
+ARENA_VEC(RowIntervals, Interval)
+ARENA_VEC(IntList, int)
+ARENA_VEC(Point2Vec, Point2)
 
 static int cmpInterval(const void *a, const void *b) {
   const Interval *ia = (const Interval *)a;
@@ -38,31 +33,26 @@ static int cmpInt(const void *a, const void *b) {
   return ia - ib;
 }
 
-static void rowAdd(RowIntervals *row, int a, int b) {
+// Rows grow interleaved, so only the last one touched can extend in place;
+// the copies the others leave behind go back with the solver's frame.
+static void rowAdd(Arena *arena, RowIntervals *row, int a, int b) {
   if (a > b) {
     int t = a;
     a = b;
     b = t;
   }
-  if (row->count == row->cap) {
-    int newCap = row->cap ? row->cap * 2 : 4;
-    Interval *n = realloc(row->arr, (size_t)newCap * sizeof(Interval));
-    if (!n) return;
-    row->arr = n;
-    row->cap = newCap;
-  }
-  row->arr[row->count++] = (Interval){a, b};
+  RowIntervalsPush(arena, row, (Interval){a, b});
 }
 
 static void mergeRow(RowIntervals *row) {
   if (row->count == 0) return;
-  qsort(row->arr, (size_t)row->count, sizeof(Interval), cmpInterval);
-  int w = 0;
-  for (int i = 0; i < row->count; ++i) {
-    if (w == 0 || row->arr[i].a > row->arr[w - 1].b + 1) {
-      row->arr[w++] = row->arr[i];
-    } else if (row->arr[i].b > row->arr[w - 1].b) {
-      row->arr[w - 1].b = row->arr[i].b;
+  qsort(row->items, row->count, sizeof(Interval), cmpInterval);
+  size_t w = 0;
+  for (size_t i = 0; i < row->count; ++i) {
+    if (w == 0 || row->items[i].a > row->items[w - 1].b + 1) {
+      row->items[w++] = row->items[i];
+    } else if (row->items[i].b > row->items[w - 1].b) {
+      row->items[w - 1].b = row->items[i].b;
     }
   }
   row->count = w;
@@ -71,13 +61,13 @@ static void mergeRow(RowIntervals *row) {
 static int rowCovered(const RowIntervals *row, int x0, int x1) {
   if (row->count == 0) return 0;
   if (row->count == 1) {
-    return row->arr[0].a <= x0 && row->arr[0].b >= x1;
+    return row->items[0].a <= x0 && row->items[0].b >= x1;
   }
   int l = 0;
-  int r = row->count - 1;
+  int r = (int)row->count - 1;
   while (l <= r) {
     int m = (l + r) / 2;
-    Interval in = row->arr[m];
+    Interval in = row->items[m];
     if (in.a > x0) {
       r = m - 1;
     } else if (in.b < x0) {
@@ -91,61 +81,42 @@ static int rowCovered(const RowIntervals *row, int x0, int x1) {
 
 static int rowsEqual(const RowIntervals *a, const RowIntervals *b) {
   if (a->count != b->count) return 0;
-  for (int i = 0; i < a->count; ++i) {
-    if (a->arr[i].a != b->arr[i].a || a->arr[i].b != b->arr[i].b) return 0;
+  for (size_t i = 0; i < a->count; ++i) {
+    if (a->items[i].a != b->items[i].a || a->items[i].b != b->items[i].b) return 0;
   }
   return 1;
 }
 
-static void intAdd(IntList *list, int v) {
-  if (list->count == list->cap) {
-    int newCap = list->cap ? list->cap * 2 : 8;
-    int *n = realloc(list->arr, (size_t)newCap * sizeof(int));
-    if (!n) return;
-    list->arr = n;
-    list->cap = newCap;
+static Point2 *parsePoints(const char *data, Arena *scratch,
+                           size_t *outCount) {
+  Point2Vec pts = {0};
+  if (!Point2VecReserve(scratch, &pts, 64)) {
+    return NULL;
   }
-  list->arr[list->count++] = v;
-}
-
-static Point2 *parsePoints(const char *data, size_t *outCount) {
-  size_t capacity = 64;
-  size_t count = 0;
-  Point2 *pts = malloc(capacity * sizeof(Point2));
   const char *p = data;
-  while (*p) {
-    while (*p == '\n' || *p == '\r') p++;
-    if (*p == '\0') break;
-    char *end;
-    int x = (int)strtol(p, &end, 10);
-    if (end == p || *end != ',') break;
-    p = end + 1;
-    int y = (int)strtol(p, &end, 10);
-    if (end == p) break;
-    if (count == capacity) {
-      capacity *= 2;
-      Point2 *n = realloc(pts, capacity * sizeof(Point2));
-      if (!n) {
-        free(pts);
-        return NULL;
-      }
-      pts = n;
+  const char *end = data + strlen(data);
+  while (p < end) {
+    while (p < end && (*p == '\n' || *p == '\r')) p++;
+    if (p == end) break;
+    long long x, y;
+    if (!fastParseI64(&p, end, &x) || p == end || *p++ != ',') break;
+    if (!fastParseI64(&p, end, &y)) break;
+    if (!Point2VecPush(scratch, &pts, (Point2){(int)x, (int)y})) {
+      return NULL;
     }
-    pts[count++] = (Point2){x, y};
-    p = end;
-    while (*p == ' ' || *p == '\t') p++;
-    if (*p == '\n') p++;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p < end && *p == '\n') p++;
   }
 
-  *outCount = count;
-  return pts;
+  *outCount = pts.count;
+  return pts.items;
 }
 
-unsigned long long day9Solve(const char *data) {
+static unsigned long long largestRectangle(const char *data,
+                                           Arena *scratch) {
   size_t count = 0;
-  Point2 *pts = parsePoints(data, &count);
+  Point2 *pts = parsePoints(data, scratch, &count);
   if (!pts || count < 2) {
-    free(pts);
     return 0;
   }
   unsigned long long best = 0;
@@ -160,15 +131,14 @@ unsigned long long day9Solve(const char *data) {
       if (area > best) best = area;
     }
   }
-  free(pts);
   return best;
 }
 
-unsigned long long day9SolvePartTwo(const char *data) {
+static unsigned long long largestInsideRectangle(const char *data,
+                                                 Arena *scratch) {
   size_t count = 0;
-  Point2 *pts = parsePoints(data, &count);
+  Point2 *pts = parsePoints(data, scratch, &count);
   if (!pts || count < 2) {
-    free(pts);
     return 0;
   }
 
@@ -181,12 +151,10 @@ unsigned long long day9SolvePartTwo(const char *data) {
   }
 
   int height = maxY - minY + 1;
-  RowIntervals *rows = calloc((size_t)height, sizeof(RowIntervals));
-  IntList *cross = calloc((size_t)height, sizeof(IntList));
+  RowIntervals *rows =
+      arenaAllocZero(scratch, (size_t)height, sizeof(RowIntervals));
+  IntList *cross = arenaAllocZero(scratch, (size_t)height, sizeof(IntList));
   if (!rows || !cross) {
-    free(rows);
-    free(cross);
-    free(pts);
     return 0;
   }
 
@@ -198,12 +166,12 @@ unsigned long long day9SolvePartTwo(const char *data) {
     if (y1 == y2) {
       int a = x1 < x2 ? x1 : x2;
       int b = x1 < x2 ? x2 : x1;
-      rowAdd(&rows[y1 - minY], a, b);
+      rowAdd(scratch, &rows[y1 - minY], a, b);
     } else if (x1 == x2) {
       int a = y1 < y2 ? y1 : y2;
       int b = y1 < y2 ? y2 : y1;
       for (int y = a; y <= b; ++y) {
-        rowAdd(&rows[y - minY], x1, x1);
+        rowAdd(scratch, &rows[y - minY], x1, x1);
       }
     }
   }
@@ -217,8 +185,8 @@ unsigned long long day9SolvePartTwo(const char *data) {
     int yStart = y1 < y2 ? y1 : y2;
     int yEnd = y1 < y2 ? y2 : y1;
     for (int y = yStart; y < yEnd; ++y) {
-      intAdd(&cross[y - minY], x1);
-      rowAdd(&rows[y - minY], x1, x1);
+      IntListPush(scratch, &cross[y - minY], x1);
+      rowAdd(scratch, &rows[y - minY], x1, x1);
     }
   }
 
@@ -226,9 +194,9 @@ unsigned long long day9SolvePartTwo(const char *data) {
   for (int r = 0; r < height; ++r) {
     IntList *ls = &cross[r];
     if (ls->count >= 2) {
-      qsort(ls->arr, (size_t)ls->count, sizeof(int), cmpInt);
-      for (int i = 0; i + 1 < ls->count; i += 2) {
-        rowAdd(&rows[r], ls->arr[i], ls->arr[i + 1]);
+      qsort(ls->items, ls->count, sizeof(int), cmpInt);
+      for (size_t i = 0; i + 1 < ls->count; i += 2) {
+        rowAdd(scratch, &rows[r], ls->items[i], ls->items[i + 1]);
       }
     }
   }
@@ -243,7 +211,10 @@ unsigned long long day9SolvePartTwo(const char *data) {
     int y1;
     RowIntervals *row;
   } RowRun;
-  RowRun *runs = malloc((size_t)height * sizeof(RowRun));
+  RowRun *runs = arenaAlloc(scratch, (size_t)height * sizeof(RowRun));
+  if (!runs) {
+    return 0;
+  }
   int runCount = 0;
   int r = 0;
   while (r < height) {
@@ -291,13 +262,21 @@ unsigned long long day9SolvePartTwo(const char *data) {
     }
   }
 
-  for (int rr = 0; rr < height; ++rr) {
-    free(rows[rr].arr);
-    free(cross[rr].arr);
-  }
-  free(rows);
-  free(cross);
-  free(runs);
-  free(pts);
+  return best;
+}
+
+unsigned long long day9Solve(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long best = largestRectangle(data, scratch);
+  arenaRelease(scratch, mark);
+  return best;
+}
+
+unsigned long long day9SolvePartTwo(const char *data) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  unsigned long long best = largestInsideRectangle(data, scratch);
+  arenaRelease(scratch, mark);
   return best;
 }
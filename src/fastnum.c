@@ -0,0 +1,131 @@
+#include "fastnum.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ONES 0x0101010101010101ULL
+
+// Number of leading digit bytes in the little-endian word x (0 to 8). A byte
+// is a digit when its high nibble is 3 and adding 6 keeps it there; carries
+// out of non-digit bytes only reach bytes after the first non-digit.
+static inline unsigned digitRun(uint64_t x) {
+  uint64_t hi = x & (0xF0 * ONES);
+  uint64_t bumped = (x + 0x06 * ONES) & (0xF0 * ONES);
+  uint64_t bad = (hi | bumped >> 4) ^ (0x33 * ONES);
+  // High bit of each byte set when that byte is non-zero (not a digit).
+  uint64_t nonZero = (((bad & (0x7F * ONES)) + 0x7F * ONES) | bad) &
+                     (0x80 * ONES);
+  return nonZero ? (unsigned)__builtin_ctzll(nonZero) / 8u : 8u;
+}
+
+// Value of eight digit bytes, first digit in the lowest byte, by pairing
+// neighbouring digits, then pairs, then quads, each in one multiply.
+static inline uint64_t eightDigits(uint64_t x) {
+  x -= 0x30 * ONES;
+  x = (x * 10 + (x >> 8)) & 0x00FF00FF00FF00FFULL;
+  x = (x * 100 + (x >> 16)) & 0x0000FFFF0000FFFFULL;
+  return (x * 10000 + (x >> 32)) & 0xFFFFFFFFULL;
+}
+
+static const uint64_t POW10[9] = {1,      10,      100,      1000,     10000,
+                                  100000, 1000000, 10000000, 100000000};
+
+int fastParseU64(const char **cursor, const char *end,
+                 unsigned long long *out) {
+  const char *p = *cursor;
+  uint64_t value = 0;
+  while (end - p >= 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    unsigned run = digitRun(word);
+    if (run == 0) {
+      break;
+    }
+    // Shifting the short runs up fills the vacated low bytes with '0'
+    // digits, which eightDigits reads as leading zeros.
+    uint64_t chunk =
+        run == 8 ? eightDigits(word)
+                 : eightDigits(word << (8 * (8 - run)) |
+                               (0x30 * ONES >> (8 * run)));
+    if (__builtin_mul_overflow(value, POW10[run], &value) ||
+        __builtin_add_overflow(value, chunk, &value)) {
+      return 0;
+    }
+    p += run;
+    if (run < 8) {
+      break;
+    }
+  }
+  while (p < end && (unsigned)(*p - '0') <= 9u) {
+    if (__builtin_mul_overflow(value, 10u, &value) ||
+        __builtin_add_overflow(value, (uint64_t)(*p - '0'), &value)) {
+      return 0;
+    }
+    p++;
+  }
+  if (p == *cursor) {
+    return 0;
+  }
+  *cursor = p;
+  *out = value;
+  return 1;
+}
+
+int fastParseI64(const char **cursor, const char *end, long long *out) {
+  const char *p = fastSkipBlanks(*cursor, end);
+  int negative = 0;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+  unsigned long long magnitude;
+  if (!fastParseU64(&p, end, &magnitude)) {
+    return 0;
+  }
+  if (negative) {
+    if (magnitude > (unsigned long long)LLONG_MAX + 1ULL) {
+      return 0;
+    }
+    *out = magnitude == (unsigned long long)LLONG_MAX + 1ULL
+               ? LLONG_MIN
+               : -(long long)magnitude;
+  } else {
+    if (magnitude > (unsigned long long)LLONG_MAX) {
+      return 0;
+    }
+    *out = (long long)magnitude;
+  }
+  *cursor = p;
+  return 1;
+}
+
+static const char *skipSeparators(const char *p, const char *end) {
+  while (p < end && (*p == ',' || *p == ' ' || *p == '\t' || *p == '\n' ||
+                     *p == '\r')) {
+    p++;
+  }
+  return p;
+}
+
+int fastParseU64List(const char *p, const char *end, Arena *arena,
+                     U64Vec *out) {
+  for (p = skipSeparators(p, end); p < end; p = skipSeparators(p, end)) {
+    unsigned long long value;
+    if (!fastParseU64(&p, end, &value) || !U64VecPush(arena, out, value)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int fastParseI64List(const char *p, const char *end, Arena *arena,
+                     I64Vec *out) {
+  for (p = skipSeparators(p, end); p < end; p = skipSeparators(p, end)) {
+    long long value;
+    if (!fastParseI64(&p, end, &value) || !I64VecPush(arena, out, value)) {
+      return 0;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,187 @@
+#include "lines.h"
+
+#include "parallel.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+enum {
+  // Bytes classified per newline mask.
+  LINES_BLOCK = 64,
+  // Inputs smaller than this per extra thread are indexed serially.
+  LINES_PARALLEL_MIN_BYTES = 1 << 20
+};
+
+ARENA_VEC(EndVec, size_t)
+
+// Bit i is set when p[i] is '\n', for the LINES_BLOCK bytes at p.
+static inline uint64_t newlineMask(const char *p) {
+#if defined(__AVX2__)
+  const __m256i newline = _mm256_set1_epi8('\n');
+  __m256i lo = _mm256_loadu_si256((const __m256i *)p);
+  __m256i hi = _mm256_loadu_si256((const __m256i *)(p + 32));
+  uint64_t low =
+      (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline));
+  uint64_t high =
+      (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newline));
+  return low | high << 32;
+#elif defined(__SSE2__)
+  const __m128i newline = _mm_set1_epi8('\n');
+  uint64_t mask = 0;
+  for (int i = 0; i < 4; ++i) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+    mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline))
+            << (16 * i);
+  }
+  return mask;
+#else
+  uint64_t mask = 0;
+  for (int i = 0; i < LINES_BLOCK; ++i) {
+    mask |= (uint64_t)(p[i] == '\n') << i;
+  }
+  return mask;
+#endif
+}
+
+static size_t countNewlines(const char *data, size_t begin, size_t end) {
+  size_t count = 0;
+  size_t i = begin;
+  for (; i + LINES_BLOCK <= end; i += LINES_BLOCK) {
+    count += (size_t)__builtin_popcountll(newlineMask(data + i));
+  }
+  for (; i < end; ++i) {
+    count += data[i] == '\n';
+  }
+  return count;
+}
+
+// Writes the offset of every '\n' in data[begin, end) to out, in order.
+static size_t storeNewlines(const char *data, size_t begin, size_t end,
+                            size_t *out) {
+  size_t count = 0;
+  size_t i = begin;
+  for (; i + LINES_BLOCK <= end; i += LINES_BLOCK) {
+    uint64_t mask = newlineMask(data + i);
+    while (mask) {
+      out[count++] = i + (size_t)__builtin_ctzll(mask);
+      mask &= mask - 1;
+    }
+  }
+  for (; i < end; ++i) {
+    if (data[i] == '\n') {
+      out[count++] = i;
+    }
+  }
+  return count;
+}
+
+// One pass that grows the offsets as it goes, so small inputs are read once.
+static int indexSerial(EndVec *ends, const char *data, size_t size,
+                       Arena *arena) {
+  size_t i = 0;
+  for (; i + LINES_BLOCK <= size; i += LINES_BLOCK) {
+    uint64_t mask = newlineMask(data + i);
+    if (!mask) {
+      continue;
+    }
+    size_t found = (size_t)__builtin_popcountll(mask);
+    if (!EndVecReserve(arena, ends, ends->count + found)) {
+      return 0;
+    }
+    while (mask) {
+      ends->items[ends->count++] = i + (size_t)__builtin_ctzll(mask);
+      mask &= mask - 1;
+    }
+  }
+  for (; i < size; ++i) {
+    if (data[i] == '\n' && !EndVecPush(arena, ends, i)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+typedef struct {
+  const char *data;
+  size_t size;
+  size_t chunks;
+  // Newlines per byte range, then (after the prefix sum) where each range's
+  // offsets start in ends.
+  size_t *counts;
+  size_t *ends;
+} IndexBatch;
+
+static size_t chunkByte(const IndexBatch *batch, size_t chunk) {
+  return chunk >= batch->chunks ? batch->size
+                                : batch->size / batch->chunks * chunk;
+}
+
+static void countChunk(void *ctx, size_t chunk, int worker) {
+  (void)worker;
+  IndexBatch *batch = ctx;
+  batch->counts[chunk] = countNewlines(batch->data, chunkByte(batch, chunk),
+                                       chunkByte(batch, chunk + 1));
+}
+
+static void storeChunk(void *ctx, size_t chunk, int worker) {
+  (void)worker;
+  IndexBatch *batch = ctx;
+  storeNewlines(batch->data, chunkByte(batch, chunk),
+                chunkByte(batch, chunk + 1),
+                batch->ends + batch->counts[chunk]);
+}
+
+// Byte ranges are independent, so one pass counts each range's newlines, a
+// prefix sum places every range in the output, and a second pass fills it.
+static int indexParallel(EndVec *ends, const char *data, size_t size,
+                         size_t chunks, Arena *arena) {
+  size_t *counts = arenaAllocZero(arena, chunks, sizeof(*counts));
+  if (!counts) {
+    return 0;
+  }
+  IndexBatch batch = {
+      .data = data,
+      .size = size,
+      .chunks = chunks,
+      .counts = counts,
+  };
+  parallelFor(chunks, countChunk, &batch);
+
+  size_t total = 0;
+  for (size_t c = 0; c < chunks; ++c) {
+    size_t count = counts[c];
+    counts[c] = total;
+    total += count;
+  }
+  // One spare slot for a last line without a '\n'.
+  if (!EndVecReserve(arena, ends, total + 1)) {
+    return 0;
+  }
+  batch.ends = ends->items;
+  parallelFor(chunks, storeChunk, &batch);
+  ends->count = total;
+  return 1;
+}
+
+int lineIndexBuild(LineIndex *index, const char *data, size_t size,
+                   Arena *arena) {
+  EndVec ends = {0};
+  size_t chunks = parallelChunkCount(size, LINES_PARALLEL_MIN_BYTES);
+  int ok = chunks <= 1 ? indexSerial(&ends, data, size, arena)
+                       : indexParallel(&ends, data, size, chunks, arena);
+  if (!ok) {
+    return 0;
+  }
+  if (size > 0 && data[size - 1] != '\n' &&
+      !EndVecPush(arena, &ends, size)) {
+    return 0;
+  }
+  index->data = data;
+  index->ends = ends.items;
+  index->count = ends.count;
+  return 1;
+}
@@ -12,6 +12,8 @@
 #include "days/day10.h"
 #include "days/day11.h"
 #include "days/day12.h"
+#include "parallel.h"
+#include "stats.h"
 #include "tools.h"
 #include "validate.h"
 
@@ -27,9 +29,11 @@
 #define PROJECT_VERSION "dev"
 #endif
 
+// First block of the run arena; it grows in further blocks as needed.
 #define ARENA_SIZE (512 * 512)
 #define START_POINTER 50
 #define DEFAULT_INPUT "input.txt"
+#define MAX_QUERY_NAMES 64
 
 static void printVersion(void) {
   const Palette *p = paletteGet();
@@ -80,40 +84,15 @@ static void printVersion(void) {
 
 static int runDay1(const char *data, size_t size, enum PartChoice part) {
   const Palette *colors = paletteGet();
-  unsigned char pointerOne = START_POINTER;
-  unsigned char pointerTwo = START_POINTER;
-  int countOne = 0;
-  int countTwo = 0;
-
-  const char *pData = data;
-  const char *end = data + size;
-
-  while (pData < end) {
-    char dirChar = *pData++;
-    unsigned int amount = 0;
-
-    while (pData < end && *pData >= '0' && *pData <= '9') {
-      amount = amount * 10u + (unsigned)(*pData - '0');
-      pData++;
-    }
-
-    if (pData < end && *pData == '\n') {
-      pData++;
-    }
-
-    enum Direction dir = (dirChar == 'R') ? Right : Left;
-
-    day1RotateFastPartOne(&pointerOne, amount, &countOne, dir);
-    day1RotateFastPartTwo(&pointerTwo, amount, &countTwo, dir);
-  }
+  Day1Counts counts = day1Count(data, size, START_POINTER);
 
   if (part == PartAll || part == PartOne) {
-    printf("%s[Part 1]%s %s%d%s\n", colors->secondary, colors->reset,
-           colors->primary, countOne, colors->reset);
+    printf("%s[Part 1]%s %s%llu%s\n", colors->secondary, colors->reset,
+           colors->primary, counts.zeroStops, colors->reset);
   }
   if (part == PartAll || part == PartTwo) {
-    printf("%s[Part 2]%s %s%d%s\n", colors->secondary, colors->reset,
-           colors->primary, countTwo, colors->reset);
+    printf("%s[Part 2]%s %s%llu%s\n", colors->secondary, colors->reset,
+           colors->primary, counts.zeroClicks, colors->reset);
   }
 
   return 0;
@@ -121,39 +100,242 @@ static int runDay1(const char *data, size_t size, enum PartChoice part) {
 
 static int runDay2(const char *data, enum PartChoice part) {
   const Palette *colors = paletteGet();
+  char buf[DAY2_TOTAL_DIGITS + 1];
   if (part == PartAll || part == PartOne) {
-    unsigned long long part1 = day2Solve(data);
-    printf("%s[Part 1]%s %s%llu%s\n", colors->secondary, colors->reset,
-           colors->primary, part1, colors->reset);
+    Day2Total part1 = day2Solve(data);
+    printf("%s[Part 1]%s %s%s%s\n", colors->secondary, colors->reset,
+           colors->primary, day2FormatTotal(part1, buf, sizeof(buf)),
+           colors->reset);
   }
   if (part == PartAll || part == PartTwo) {
-    unsigned long long part2 = day2SolvePartTwo(data);
-    printf("%s[Part 2]%s %s%llu%s\n", colors->secondary, colors->reset,
-           colors->primary, part2, colors->reset);
+    Day2Total part2 = day2SolvePartTwo(data);
+    printf("%s[Part 2]%s %s%s%s\n", colors->secondary, colors->reset,
+           colors->primary, day2FormatTotal(part2, buf, sizeof(buf)),
+           colors->reset);
   }
   return 0;
 }
 
-static int runDay3(const char *data, enum PartChoice part) {
+static int runDay3(const char *data, size_t size, enum PartChoice part,
+                   unsigned digits) {
   const Palette *colors = paletteGet();
   if (part == PartAll || part == PartOne) {
-    unsigned long long part1 = day3Solve(data);
+    unsigned long long part1 = day3Solve(data, size);
     printf("%s[Part 1]%s %s%llu%s\n", colors->secondary, colors->reset,
            colors->primary, part1, colors->reset);
   }
   if (part == PartAll || part == PartTwo) {
-    unsigned long long part2 = day3SolvePartTwo(data);
+    unsigned long long part2 = digits ? day3SolveK(data, size, (int)digits)
+                                      : day3SolvePartTwo(data, size);
     printf("%s[Part 2]%s %s%llu%s\n", colors->secondary, colors->reset,
            colors->primary, part2, colors->reset);
   }
   return 0;
 }
 
+static int printDay11(int partNum, Day11Status status,
+                      unsigned long long value) {
+  const Palette *colors = paletteGet();
+  if (status != Day11Ok) {
+    fprintf(stderr, "%s[Part %d]%s %s\n", colors->error, partNum,
+            colors->reset, day11StatusMessage(status));
+    return 1;
+  }
+  printf("%s[Part %d]%s %s%llu%s\n", colors->secondary, partNum,
+         colors->reset, colors->primary, value, colors->reset);
+  return 0;
+}
+
+static void reportInvalidInput(unsigned int day, const char *message) {
+  const Palette *p = paletteGet();
+  fprintf(stderr, "%sInvalid input for day %u:%s %s\n", p->error, day,
+          p->reset, message);
+  fprintf(stderr, "%sUse --input to point at the correct file for this day.%s\n",
+          p->warn, p->reset);
+}
+
+// Parses the graph strictly, reporting malformed input like the validator
+// would; NULL once the problem has been printed.
+static Day11Graph *loadDay11(const char *data, size_t size) {
+  char errBuf[256];
+  Day11Graph *graph =
+      day11GraphCreateStrict(data, size, errBuf, sizeof(errBuf));
+  if (!graph) {
+    if (errBuf[0]) {
+      reportInvalidInput(11, errBuf);
+    } else {
+      const Palette *colors = paletteGet();
+      fprintf(stderr, "%s%s%s\n", colors->error,
+              day11StatusMessage(Day11OutOfMemory), colors->reset);
+    }
+  }
+  return graph;
+}
+
+// Both parts are answered from one parsed graph.
+static int runDay11(const char *data, size_t size, enum PartChoice part) {
+  static const char *const required[] = {"dac", "fft"};
+  Day11Graph *graph = loadDay11(data, size);
+  if (!graph) {
+    return 1;
+  }
+  int exitCode = 0;
+  unsigned long long value;
+  if (part == PartAll || part == PartOne) {
+    Day11Status status =
+        day11GraphCountPaths(graph, "you", "out", NULL, 0, &value);
+    exitCode |= printDay11(1, status, value);
+  }
+  if (part == PartAll || part == PartTwo) {
+    Day11Status status =
+        day11GraphCountPaths(graph, "svr", "out", required, 2, &value);
+    exitCode |= printDay11(2, status, value);
+  }
+  day11GraphDestroy(graph);
+  return exitCode;
+}
+
+// Answers one "src dst [via...]" query per line of the queries file against a
+// single parsed graph. Blank lines and lines starting with '#' are skipped.
+static int runDay11Queries(const char *data, size_t dataSize,
+                           const char *queriesPath) {
+  const Palette *colors = paletteGet();
+  size_t size;
+  char *queries = readFile(queriesPath, &size, arenaScratch());
+  if (!queries) {
+    fprintf(stderr, "%sFailed to read queries file:%s %s\n", colors->error,
+            colors->reset, queriesPath);
+    return 1;
+  }
+  Day11Graph *graph = loadDay11(data, dataSize);
+  if (!graph) {
+    return 1;
+  }
+
+  int exitCode = 0;
+  unsigned queryNum = 0;
+  char *p = queries;
+  while (*p) {
+    char *line = p;
+    while (*p && *p != '\n') {
+      p++;
+    }
+    if (*p == '\n') {
+      *p++ = '\0';
+    }
+
+    const char *names[MAX_QUERY_NAMES];
+    int count = 0;
+    char *q = line;
+    while (*q && *q != '#') {
+      while (*q == ' ' || *q == '\t' || *q == '\r') {
+        q++;
+      }
+      if (*q == '\0' || *q == '#') {
+        break;
+      }
+      if (count == MAX_QUERY_NAMES) {
+        count = -1;
+        break;
+      }
+      names[count++] = q;
+      while (*q && *q != ' ' && *q != '\t' && *q != '\r') {
+        q++;
+      }
+      if (*q) {
+        *q++ = '\0';
+      }
+    }
+    if (count == 0) {
+      continue;
+    }
+
+    queryNum++;
+    if (count < 0) {
+      fprintf(stderr, "%s[Query %u]%s more than %d names on one line\n",
+              colors->error, queryNum, colors->reset, MAX_QUERY_NAMES);
+      exitCode = 1;
+      continue;
+    }
+    if (count < 2) {
+      fprintf(stderr, "%s[Query %u]%s expected 'source target [via...]'\n",
+              colors->error, queryNum, colors->reset);
+      exitCode = 1;
+      continue;
+    }
+    unsigned long long value;
+    Day11Status status = day11GraphCountPaths(graph, names[0], names[1],
+                                              names + 2, count - 2, &value);
+    if (status != Day11Ok) {
+      fprintf(stderr, "%s[Query %u]%s %s\n", colors->error, queryNum,
+              colors->reset, day11StatusMessage(status));
+      exitCode = 1;
+      continue;
+    }
+    printf("%s[Query %u]%s %s%llu%s\n", colors->secondary, queryNum,
+           colors->reset, colors->primary, value, colors->reset);
+  }
+
+  day11GraphDestroy(graph);
+  return exitCode;
+}
+
+// Without a budget every region is searched to completion. With one, the run
+// stops at the first region that exhausts it, since the count is then
+// unknown.
+static int runDay12(const char *data, size_t size,
+                    const ArgParseResult *args) {
+  const Palette *colors = paletteGet();
+  char errBuf[256];
+  int exitCode = 0;
+  if (args->part == PartAll || args->part == PartOne) {
+    Day12Limits limits = {
+        .nodeBudget = args->node_budget,
+        .timeBudgetMs = args->time_budget_ms,
+        .stopWhenUndecided = 1,
+    };
+    Day12Result result;
+    if (!day12CountStrict(data, size, &limits, &result, errBuf,
+                          sizeof(errBuf))) {
+      reportInvalidInput(12, errBuf);
+      return 1;
+    }
+    if (result.undecided > 0) {
+      fprintf(stderr,
+              "%sDay 12: a region exhausted the search budget or is too large "
+              "to search; the count is "
+              "undecided (%llu fit so far, %llu regions not searched).%s\n",
+              colors->error, result.fit, result.skipped, colors->reset);
+      exitCode = 1;
+    } else {
+      printf("%s[Part 1]%s %s%llu%s\n", colors->secondary, colors->reset,
+             colors->primary, result.fit, colors->reset);
+    }
+  }
+  if (args->part == PartAll || args->part == PartTwo) {
+    if (args->part == PartTwo) {
+      if (!day12Validate(data, size, errBuf, sizeof(errBuf))) {
+        reportInvalidInput(12, errBuf);
+        return 1;
+      }
+      fprintf(stderr, "%sDay 12 has no Part 2 in this event.%s\n",
+              colors->warn, colors->reset);
+      exitCode = 1;
+    } else {
+      fprintf(stderr, "%sDay 12 has no Part 2 in this event; skipping.%s\n",
+              colors->warn, colors->reset);
+    }
+  }
+  return exitCode;
+}
+
 int main(int argc, char **argv) {
   Arena arena = arenaCreate(ARENA_SIZE);
   if (!arena.base) {
     return 1;
   }
+  // Solvers take their scratch buffers from the run arena.
+  arenaSetScratch(&arena);
 
   ArgParseResult args = parseArgs(argc, argv, DEFAULT_INPUT);
   const Palette *p = paletteGet();
@@ -174,6 +356,10 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (args.threads > 0) {
+    parallelSetThreadCount((int)args.threads);
+  }
+
   size_t size;
   char *data = readFile(args.input_path, &size, &arena);
   if (!data) {
@@ -185,23 +371,31 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  // Days with a strict parser report malformed input while solving.
+  // Their validation cost is part of run.solve, so run.validate is only
+  // recorded for days with a separate pass.
   char errBuf[256];
-  if (!validateInputForDay(args.day, data, size, errBuf, sizeof(errBuf))) {
-    fprintf(stderr, "%sInvalid input for day %u:%s %s\n", p->error,
-            (unsigned)args.day, p->reset, errBuf);
-    fprintf(stderr, "%sUse --input to point at the correct file for this day.%s\n",
-            p->warn, p->reset);
+  int valid = 1;
+  if (!validateFusedWithParse(args.day)) {
+    STAT_TIMER_START(VALIDATE);
+    valid = validateInputForDay(args.day, data, size, errBuf, sizeof(errBuf));
+    STAT_TIMER_STOP(VALIDATE);
+  }
+  if (!valid) {
+    reportInvalidInput(args.day, errBuf);
+    parallelShutdown();
     arenaDestroy(&arena);
     return 1;
   }
 
+  STAT_TIMER_START(SOLVE);
   int exitCode = 0;
   if (args.day == 1) {
     exitCode = runDay1(data, size, args.part);
   } else if (args.day == 2) {
     exitCode = runDay2(data, args.part);
   } else if (args.day == 3) {
-    exitCode = runDay3(data, args.part);
+    exitCode = runDay3(data, size, args.part, args.digits);
   } else if (args.day == 4) {
     if (args.part == PartAll || args.part == PartOne) {
       unsigned long long part1 = day4Solve(data);
@@ -279,35 +473,12 @@ int main(int argc, char **argv) {
       printf("%s[Part 2]%s %s%llu%s\n", p->secondary, p->reset, p->primary,
              part2, p->reset);
     }
+  } else if (args.day == 11 && args.queries_path) {
+    exitCode = runDay11Queries(data, size, args.queries_path);
   } else if (args.day == 11) {
-    if (args.part == PartAll || args.part == PartOne) {
-      unsigned long long part1 = day11Solve(data);
-      printf("%s[Part 1]%s %s%llu%s\n", p->secondary, p->reset, p->primary,
-             part1, p->reset);
-    }
-    if (args.part == PartAll || args.part == PartTwo) {
-      unsigned long long part2 = day11SolvePartTwo(data);
-      printf("%s[Part 2]%s %s%llu%s\n", p->secondary, p->reset, p->primary,
-             part2, p->reset);
-    }
+    exitCode = runDay11(data, size, args.part);
   } else if (args.day == 12) {
-    if (args.part == PartAll || args.part == PartOne) {
-      unsigned long long part1 = day12Solve(data);
-      printf("%s[Part 1]%s %s%llu%s\n", p->secondary, p->reset, p->primary,
-             part1, p->reset);
-    }
-    if (args.part == PartAll || args.part == PartTwo) {
-      if (args.part == PartTwo) {
-        fprintf(stderr,
-                "%sDay 12 has no Part 2 in this event.%s\n",
-                p->warn, p->reset);
-        exitCode = 1;
-      } else {
-        fprintf(stderr,
-                "%sDay 12 has no Part 2 in this event; skipping.%s\n",
-                p->warn, p->reset);
-      }
-    }
+    exitCode = runDay12(data, size, &args);
   } else {
     fprintf(stderr, "%sUnsupported day:%s %u\n", p->error, p->reset,
             (unsigned)args.day);
@@ -316,7 +487,18 @@ int main(int argc, char **argv) {
             p->warn, p->reset);
     exitCode = 1;
   }
+  STAT_TIMER_STOP(SOLVE);
+
+  if (args.stats != StatsOff) {
+    if (statsEnabled()) {
+      statsPrint(stdout, args.stats == StatsShowJson ? StatsJson : StatsTable);
+    } else {
+      fprintf(stderr, "%s--stats needs a build with STATS=1%s\n", p->warn,
+              p->reset);
+    }
+  }
 
+  parallelShutdown();
   arenaDestroy(&arena);
   return exitCode;
 }
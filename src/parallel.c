@@ -0,0 +1,215 @@
+#define _DEFAULT_SOURCE
+
+#include "parallel.h"
+
+#include "stats.h"
+#include "tools.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+enum { PARALLEL_MAX_THREADS = 256 };
+
+static int threadCount = 0;
+
+// Scratch arenas for the spawned workers, kept across calls so blocks grown
+// by one pool run are reused by the next. Worker 0 is the calling thread and
+// keeps its own scratch arena.
+static Arena workerArenas[PARALLEL_MAX_THREADS];
+
+static void useWorkerArena(int worker) {
+  if (worker <= 0) {
+    return;
+  }
+  Arena *arena = &workerArenas[worker];
+  if (!arena->block) {
+    *arena = arenaCreate(0);
+  }
+  arenaSetScratch(arena);
+}
+
+void parallelShutdown(void) {
+  for (int i = 0; i < PARALLEL_MAX_THREADS; ++i) {
+    arenaDestroy(&workerArenas[i]);
+  }
+}
+
+int parallelThreadCount(void) {
+  if (threadCount <= 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threadCount = online > 0 ? (int)online : 1;
+    if (threadCount > PARALLEL_MAX_THREADS) {
+      threadCount = PARALLEL_MAX_THREADS;
+    }
+  }
+  return threadCount;
+}
+
+void parallelSetThreadCount(int count) {
+  if (count > PARALLEL_MAX_THREADS) {
+    count = PARALLEL_MAX_THREADS;
+  }
+  threadCount = count;
+}
+
+typedef struct {
+  ParallelTaskFn fn;
+  void *ctx;
+  size_t begin;
+  size_t end;
+  int worker;
+} ParallelBlock;
+
+// Each task runs in its own scratch frame, so nothing a task allocates
+// outlives it.
+static void runTask(ParallelTaskFn fn, void *ctx, size_t task, int worker) {
+  Arena *scratch = arenaScratch();
+  ArenaMark mark = arenaMark(scratch);
+  fn(ctx, task, worker);
+  arenaRelease(scratch, mark);
+  STATS_FLUSH();
+}
+
+static void runBlock(const ParallelBlock *block) {
+  for (size_t task = block->begin; task < block->end; ++task) {
+    runTask(block->fn, block->ctx, task, block->worker);
+  }
+}
+
+static void *blockThread(void *arg) {
+  const ParallelBlock *block = arg;
+  useWorkerArena(block->worker);
+  runBlock(block);
+  return NULL;
+}
+
+void parallelFor(size_t taskCount, ParallelTaskFn fn, void *ctx) {
+  if (taskCount == 0) {
+    return;
+  }
+  size_t workers = (size_t)parallelThreadCount();
+  if (workers > taskCount) {
+    workers = taskCount;
+  }
+
+  ParallelBlock blocks[PARALLEL_MAX_THREADS];
+  pthread_t threads[PARALLEL_MAX_THREADS];
+  int started[PARALLEL_MAX_THREADS];
+  for (size_t w = 0; w < workers; ++w) {
+    blocks[w] = (ParallelBlock){
+        .fn = fn,
+        .ctx = ctx,
+        .begin = taskCount * w / workers,
+        .end = taskCount * (w + 1) / workers,
+        .worker = (int)w,
+    };
+  }
+
+  for (size_t w = 1; w < workers; ++w) {
+    started[w] =
+        pthread_create(&threads[w], NULL, blockThread, &blocks[w]) == 0;
+  }
+  runBlock(&blocks[0]);
+  for (size_t w = 1; w < workers; ++w) {
+    if (started[w]) {
+      pthread_join(threads[w], NULL);
+    } else {
+      // Thread creation failed: fall back to running the block here.
+      runBlock(&blocks[w]);
+    }
+  }
+}
+
+typedef struct {
+  ParallelTaskFn fn;
+  void *ctx;
+  size_t taskCount;
+  atomic_size_t next;
+  atomic_int *cancel;
+} ParallelQueue;
+
+typedef struct {
+  ParallelQueue *queue;
+  int worker;
+} ParallelClaimer;
+
+static void runClaims(const ParallelClaimer *claimer) {
+  ParallelQueue *queue = claimer->queue;
+  for (;;) {
+    if (queue->cancel && atomic_load(queue->cancel)) {
+      return;
+    }
+    size_t task = atomic_fetch_add(&queue->next, 1);
+    if (task >= queue->taskCount) {
+      return;
+    }
+    runTask(queue->fn, queue->ctx, task, claimer->worker);
+  }
+}
+
+static void *claimThread(void *arg) {
+  const ParallelClaimer *claimer = arg;
+  useWorkerArena(claimer->worker);
+  runClaims(claimer);
+  return NULL;
+}
+
+void parallelForDynamic(size_t taskCount, ParallelTaskFn fn, void *ctx,
+                        atomic_int *cancel) {
+  if (taskCount == 0) {
+    return;
+  }
+  size_t workers = (size_t)parallelThreadCount();
+  if (workers > taskCount) {
+    workers = taskCount;
+  }
+
+  ParallelQueue queue = {
+      .fn = fn,
+      .ctx = ctx,
+      .taskCount = taskCount,
+      .cancel = cancel,
+  };
+  atomic_init(&queue.next, 0);
+  ParallelClaimer claimers[PARALLEL_MAX_THREADS];
+  pthread_t threads[PARALLEL_MAX_THREADS];
+  int started[PARALLEL_MAX_THREADS];
+  for (size_t w = 0; w < workers; ++w) {
+    claimers[w] = (ParallelClaimer){.queue = &queue, .worker = (int)w};
+  }
+
+  for (size_t w = 1; w < workers; ++w) {
+    started[w] =
+        pthread_create(&threads[w], NULL, claimThread, &claimers[w]) == 0;
+  }
+  // Workers that failed to start simply leave their share to the others.
+  runClaims(&claimers[0]);
+  for (size_t w = 1; w < workers; ++w) {
+    if (started[w]) {
+      pthread_join(threads[w], NULL);
+    }
+  }
+}
+
+size_t parallelChunkCount(size_t size, size_t minBytes) {
+  size_t chunks = (size_t)parallelThreadCount();
+  if (minBytes > 0 && chunks > size / minBytes) {
+    chunks = size / minBytes;
+  }
+  return chunks > 0 ? chunks : 1;
+}
+
+const char *parallelLineChunk(const char *data, size_t size, size_t chunks,
+                              size_t chunk) {
+  if (chunk == 0) {
+    return data;
+  }
+  const char *end = data + size;
+  if (chunk >= chunks) {
+    return end;
+  }
+  const char *p = data + size / chunks * chunk;
+  const char *nl = memchr(p, '\n', (size_t)(end - p));
+  return nl ? nl + 1 : end;
+}
@@ -0,0 +1,94 @@
+#define _DEFAULT_SOURCE
+
+#include "stats.h"
+
+#ifdef AOC_STATS
+
+#include <stdatomic.h>
+#include <time.h>
+
+_Thread_local StatsSlots statsLocal;
+
+static atomic_ullong counterTotals[STAT_COUNTER_COUNT];
+static atomic_ullong timerNsTotals[STAT_TIMER_COUNT];
+static atomic_ullong timerCallTotals[STAT_TIMER_COUNT];
+
+#define STATS_NAME_ENTRY(id, name) name,
+static const char *const counterNames[] = {STATS_COUNTERS(STATS_NAME_ENTRY)};
+static const char *const timerNames[] = {STATS_TIMERS(STATS_NAME_ENTRY)};
+#undef STATS_NAME_ENTRY
+
+int statsEnabled(void) { return 1; }
+
+unsigned long long statsNowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL +
+         (unsigned long long)ts.tv_nsec;
+}
+
+static void flushSlot(atomic_ullong *total, unsigned long long *local) {
+  if (*local) {
+    atomic_fetch_add_explicit(total, *local, memory_order_relaxed);
+    *local = 0;
+  }
+}
+
+void statsFlush(void) {
+  for (int i = 0; i < STAT_COUNTER_COUNT; ++i) {
+    flushSlot(&counterTotals[i], &statsLocal.counters[i]);
+  }
+  for (int i = 0; i < STAT_TIMER_COUNT; ++i) {
+    flushSlot(&timerNsTotals[i], &statsLocal.timerNs[i]);
+    flushSlot(&timerCallTotals[i], &statsLocal.timerCalls[i]);
+  }
+}
+
+// The table leaves out what never happened on this run; JSON lists every
+// entry so its shape does not depend on the day.
+void statsPrint(FILE *out, StatsFormat format) {
+  statsFlush();
+  if (format == StatsJson) {
+    fprintf(out, "{\"counters\": {");
+    for (int i = 0; i < STAT_COUNTER_COUNT; ++i) {
+      fprintf(out, "%s\"%s\": %llu", i ? ", " : "", counterNames[i],
+              atomic_load(&counterTotals[i]));
+    }
+    fprintf(out, "}, \"timers\": {");
+    for (int i = 0; i < STAT_TIMER_COUNT; ++i) {
+      fprintf(out, "%s\"%s\": {\"calls\": %llu, \"ms\": %.3f}",
+              i ? ", " : "", timerNames[i], atomic_load(&timerCallTotals[i]),
+              (double)atomic_load(&timerNsTotals[i]) / 1e6);
+    }
+    fprintf(out, "}}\n");
+    return;
+  }
+  fprintf(out, "%-28s %16s\n", "counter", "value");
+  for (int i = 0; i < STAT_COUNTER_COUNT; ++i) {
+    unsigned long long value = atomic_load(&counterTotals[i]);
+    if (value) {
+      fprintf(out, "%-28s %16llu\n", counterNames[i], value);
+    }
+  }
+  fprintf(out, "%-28s %16s %12s\n", "timer", "calls", "total ms");
+  for (int i = 0; i < STAT_TIMER_COUNT; ++i) {
+    unsigned long long calls = atomic_load(&timerCallTotals[i]);
+    if (calls) {
+      fprintf(out, "%-28s %16llu %12.3f\n", timerNames[i], calls,
+              (double)atomic_load(&timerNsTotals[i]) / 1e6);
+    }
+  }
+}
+
+#else
+
+int statsEnabled(void) { return 0; }
+
+void statsFlush(void) {}
+
+void statsPrint(FILE *out, StatsFormat format) {
+  (void)out;
+  (void)format;
+}
+
+#endif
@@ -1,34 +1,198 @@
 #include "tools.h"
 
+#include "lines.h"
+
 #include <stdalign.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define ALIGN_UP(x, a) (((x) + (a)-1) & ~((a)-1))
 
+enum {
+  // Smallest block the arena will add when it grows.
+  ARENA_MIN_BLOCK = 64 * 1024
+};
+
+struct ArenaBlock {
+  ArenaBlock *prev;
+  ArenaBlock *next;
+  size_t capacity;
+  alignas(max_align_t) unsigned char data[];
+};
+
+static ArenaBlock *blockCreate(size_t capacity) {
+  ArenaBlock *block = malloc(sizeof(ArenaBlock) + capacity);
+  if (!block) {
+    return NULL;
+  }
+  block->prev = NULL;
+  block->next = NULL;
+  block->capacity = capacity;
+  return block;
+}
+
+static void arenaUse(Arena *arena, ArenaBlock *block, size_t offset) {
+  arena->block = block;
+  arena->base = block ? block->data : NULL;
+  arena->capacity = block ? block->capacity : 0;
+  arena->offset = offset;
+}
+
 Arena arenaCreate(size_t capacity) {
   Arena arena;
-  arena.base = malloc(capacity);
-  arena.capacity = capacity;
-  arena.offset = 0;
+  arenaUse(&arena, blockCreate(capacity), 0);
   return arena;
 }
 
+// Moves on to a block with room for size bytes at alignment align: the next
+// spare block if it is large enough, otherwise a new one. Spares too small
+// to use are freed.
+static int arenaGrow(Arena *arena, size_t size, size_t align) {
+  ArenaBlock *next = arena->block ? arena->block->next : NULL;
+  if (next && next->capacity >= size + align) {
+    arenaUse(arena, next, 0);
+    return 1;
+  }
+  while (next) {
+    ArenaBlock *after = next->next;
+    free(next);
+    next = after;
+  }
+  size_t capacity = arena->capacity * 2;
+  if (capacity < ARENA_MIN_BLOCK) {
+    capacity = ARENA_MIN_BLOCK;
+  }
+  if (capacity < size + align) {
+    capacity = size + align;
+  }
+  ArenaBlock *block = blockCreate(capacity);
+  if (!block) {
+    return 0;
+  }
+  block->prev = arena->block;
+  if (arena->block) {
+    arena->block->next = block;
+  }
+  arenaUse(arena, block, 0);
+  return 1;
+}
+
+// Offset into the current block at which an allocation aligned to align can
+// start. Block data is only aligned to max_align_t, so the address is
+// rounded up rather than the offset.
+static size_t alignedStart(const Arena *arena, size_t align) {
+  uintptr_t base = (uintptr_t)arena->base;
+  return (size_t)(ALIGN_UP(base + arena->offset, align) - base);
+}
+
+void *arenaAllocAligned(Arena *arena, size_t size, size_t align) {
+  size_t start = arena->block ? alignedStart(arena, align) : 0;
+  if (!arena->block || start > arena->capacity ||
+      size > arena->capacity - start) {
+    if (!arenaGrow(arena, size, align)) {
+      return NULL;
+    }
+    start = alignedStart(arena, align);
+  }
+  arena->offset = start + size;
+  return arena->base + start;
+}
+
 void *arenaAlloc(Arena *arena, size_t size) {
-  size = ALIGN_UP(size, alignof(max_align_t));
-  if (arena->offset + size > arena->capacity) {
+  return arenaAllocAligned(arena, size, alignof(max_align_t));
+}
+
+void *arenaAllocZero(Arena *arena, size_t count, size_t size) {
+  if (size != 0 && count > SIZE_MAX / size) {
     return NULL;
   }
-  void *ptr = arena->base + arena->offset;
-  arena->offset += size;
+  void *ptr = arenaAlloc(arena, count * size);
+  if (ptr) {
+    memset(ptr, 0, count * size);
+  }
   return ptr;
 }
 
-void arenaReset(Arena *arena) { arena->offset = 0; }
+void *arenaRealloc(Arena *arena, void *ptr, size_t oldSize, size_t newSize) {
+  unsigned char *bytes = ptr;
+  if (bytes && arena->block && bytes + oldSize == arena->base + arena->offset &&
+      newSize <= arena->capacity - (size_t)(bytes - arena->base)) {
+    arena->offset = (size_t)(bytes - arena->base) + newSize;
+    return ptr;
+  }
+  void *moved = arenaAlloc(arena, newSize);
+  if (moved && bytes) {
+    memcpy(moved, bytes, oldSize < newSize ? oldSize : newSize);
+  }
+  return moved;
+}
+
+int arenaVecGrow(Arena *arena, void **items, size_t *capacity,
+                 size_t elemSize, size_t minCapacity) {
+  size_t grown = *capacity ? *capacity * 2 : 8;
+  if (grown < minCapacity) {
+    grown = minCapacity;
+  }
+  if (elemSize != 0 && grown > SIZE_MAX / elemSize) {
+    return 0;
+  }
+  void *moved =
+      arenaRealloc(arena, *items, *capacity * elemSize, grown * elemSize);
+  if (!moved) {
+    return 0;
+  }
+  *items = moved;
+  *capacity = grown;
+  return 1;
+}
+
+ArenaMark arenaMark(const Arena *arena) {
+  ArenaMark mark = {arena->block, arena->offset};
+  return mark;
+}
+
+void arenaRelease(Arena *arena, ArenaMark mark) {
+  if (mark.block) {
+    arenaUse(arena, mark.block, mark.offset);
+  }
+}
+
+void arenaReset(Arena *arena) {
+  ArenaBlock *first = arena->block;
+  while (first && first->prev) {
+    first = first->prev;
+  }
+  arenaUse(arena, first, 0);
+}
+
+void arenaDestroy(Arena *arena) {
+  arenaReset(arena);
+  ArenaBlock *block = arena->block;
+  while (block) {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  arenaUse(arena, NULL, 0);
+}
+
+static _Thread_local Arena *scratchArena;
+static _Thread_local Arena fallbackScratch;
+
+Arena *arenaScratch(void) {
+  if (!scratchArena) {
+    if (!fallbackScratch.block) {
+      fallbackScratch = arenaCreate(ARENA_MIN_BLOCK);
+    }
+    scratchArena = &fallbackScratch;
+  }
+  return scratchArena;
+}
 
-void arenaDestroy(Arena *arena) { free(arena->base); }
+void arenaSetScratch(Arena *arena) { scratchArena = arena; }
 
 char *readFile(const char *fileName, size_t *outSize, Arena *arena) {
   FILE *f = fopen(fileName, "rb");
@@ -69,51 +233,18 @@ char *readFile(const char *fileName, size_t *outSize, Arena *arena) {
 
 char **getLines(char *fileContent, size_t *outCount, Arena *arena) {
   size_t len = strlen(fileContent);
-  size_t lines = 0;
-
-  for (size_t i = 0; i < len; ++i) {
-    if (fileContent[i] == '\n') {
-      lines++;
-    }
-  }
-
-  if (len > 0 && fileContent[len - 1] != '\n') {
-    lines++;
+  LineIndex index;
+  if (!lineIndexBuild(&index, fileContent, len, arena)) {
+    return NULL;
   }
-
-  char **result = arenaAlloc(arena, lines * sizeof(char *));
+  char **result = arenaAlloc(arena, index.count * sizeof(char *));
   if (!result) {
     return NULL;
   }
-
-  size_t idx = 0;
-  char *start = fileContent;
-
-  for (size_t i = 0; i < len; ++i) {
-    if (fileContent[i] == '\n') {
-      fileContent[i] = '\0';
-      result[idx++] = start;
-      start = fileContent + i + 1;
-    }
-  }
-
-  if (start < fileContent + len) {
-    result[idx++] = start;
+  for (size_t i = 0; i < index.count; ++i) {
+    result[i] = fileContent + lineStart(&index, i);
+    fileContent[index.ends[i]] = '\0';
   }
-
-  *outCount = idx;
+  *outCount = index.count;
   return result;
 }
-
-unsigned long long parseULL(const char *s, const char **endOut) {
-  unsigned long long val = 0;
-  const char *p = s;
-  while (*p >= '0' && *p <= '9') {
-    val = val * 10ULL + (unsigned long long)(*p - '0');
-    p++;
-  }
-  if (endOut) {
-    *endOut = p;
-  }
-  return val;
-}
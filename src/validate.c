@@ -1,11 +1,18 @@
 #include "validate.h"
 
+#include "days/day11.h"
+#include "days/day12.h"
 #include "tools.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 static void setErr(char *buf, size_t n, const char *msg) {
   if (n == 0) {
     return;
@@ -17,6 +24,93 @@ static void setErr(char *buf, size_t n, const char *msg) {
   }
 }
 
+int parseFail(const ParseError *err, const char *msg) {
+  setErr(err->buf, err->size, msg);
+  return 0;
+}
+
+// Appends the line and column of data[offset] to msg.
+static void setErrAt(char *buf, size_t n, const char *msg, const char *data,
+                     size_t offset) {
+  size_t line = 1;
+  size_t lineStart = 0;
+  for (size_t i = 0; i < offset; ++i) {
+    if (data[i] == '\n') {
+      line++;
+      lineStart = i + 1;
+    }
+  }
+  if (n > 0) {
+    snprintf(buf, n, "%s First bad byte at line %zu, column %zu.", msg, line,
+             offset - lineStart + 1);
+  }
+}
+
+// The bytes a character-class validator accepts: the range [lo, hi], whose
+// presence the validator also needs to know about, plus up to a few extras
+// (newlines, filler cells).
+typedef struct {
+  unsigned char lo;
+  unsigned char hi;
+  const char *extras;
+} ByteClass;
+
+static int classHas(const ByteClass *cls, unsigned char c, int *inRange) {
+  if ((unsigned char)(c - cls->lo) <= (unsigned char)(cls->hi - cls->lo)) {
+    *inRange = 1;
+    return 1;
+  }
+  return c != '\0' && strchr(cls->extras, c) != NULL;
+}
+
+#ifdef __AVX2__
+// Bit i set when p[i] is in the class; the range part is also ORed into
+// *seen. The range test is (c - lo) <= (hi - lo) as a saturating subtract.
+static inline uint32_t classMask32(const char *p, const ByteClass *cls,
+                                   __m256i *seen) {
+  __m256i v = _mm256_loadu_si256((const __m256i *)p);
+  __m256i offset = _mm256_sub_epi8(v, _mm256_set1_epi8((char)cls->lo));
+  __m256i inRange = _mm256_cmpeq_epi8(
+      _mm256_subs_epu8(offset,
+                       _mm256_set1_epi8((char)(cls->hi - cls->lo))),
+      _mm256_setzero_si256());
+  *seen = _mm256_or_si256(*seen, inRange);
+  __m256i ok = inRange;
+  for (const char *e = cls->extras; *e; ++e) {
+    ok = _mm256_or_si256(ok, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(*e)));
+  }
+  return (uint32_t)_mm256_movemask_epi8(ok);
+}
+#endif
+
+// Offset of the first byte of data[0, size) outside cls, or size when every
+// byte belongs. 64 bytes are classified per step with range compares, and
+// only a block that fails is looked at more closely. *inRange is set when a
+// byte of the range part was seen.
+static size_t classScan(const char *data, size_t size, const ByteClass *cls,
+                        int *inRange) {
+  size_t i = 0;
+#ifdef __AVX2__
+  __m256i seen = _mm256_setzero_si256();
+  for (; i + 64 <= size; i += 64) {
+    uint64_t ok = (uint64_t)classMask32(data + i, cls, &seen) |
+                  (uint64_t)classMask32(data + i + 32, cls, &seen) << 32;
+    if (~ok) {
+      return i + (size_t)__builtin_ctzll(~ok);
+    }
+  }
+  if (!_mm256_testz_si256(seen, seen)) {
+    *inRange = 1;
+  }
+#endif
+  for (; i < size; ++i) {
+    if (!classHas(cls, (unsigned char)data[i], inRange)) {
+      return i;
+    }
+  }
+  return size;
+}
+
 static int parseUnsigned(const char **p, unsigned long long *out) {
   char *end;
   unsigned long long v = strtoull(*p, &end, 10);
@@ -80,6 +174,30 @@ static int validateDay1(const char *data, size_t size, char *err,
   return 1;
 }
 
+// Day 2 bounds are parsed into 128 bits; reject anything larger rather than
+// letting it wrap.
+static int scanDay2Bound(const char **p) {
+  static const char maxBound[] = "340282366920938463463374607431768211455";
+  const char *s = *p;
+  if (!isDigit(*s)) {
+    return 0;
+  }
+  while (*s == '0' && isDigit(s[1])) {
+    s++;
+  }
+  const char *digits = s;
+  while (isDigit(*s)) {
+    s++;
+  }
+  size_t len = (size_t)(s - digits);
+  *p = s;
+  if (len > sizeof(maxBound) - 1 ||
+      (len == sizeof(maxBound) - 1 && strncmp(digits, maxBound, len) > 0)) {
+    return -1;
+  }
+  return 1;
+}
+
 static int validateDay2(const char *data, size_t size, char *err,
                         size_t errSize) {
   (void)size;
@@ -92,11 +210,15 @@ static int validateDay2(const char *data, size_t size, char *err,
     if (*p == '\0') {
       break;
     }
-    unsigned long long start, end;
-    if (!parseUnsigned(&p, &start)) {
+    int bound = scanDay2Bound(&p);
+    if (bound == 0) {
       setErr(err, errSize, "Day 2 range is missing a start number.");
       return 0;
     }
+    if (bound < 0) {
+      setErr(err, errSize, "Day 2 range bounds must fit in 128 bits.");
+      return 0;
+    }
     while (*p == ' ') {
       p++;
     }
@@ -108,10 +230,15 @@ static int validateDay2(const char *data, size_t size, char *err,
     while (*p == ' ') {
       p++;
     }
-    if (!parseUnsigned(&p, &end)) {
+    bound = scanDay2Bound(&p);
+    if (bound == 0) {
       setErr(err, errSize, "Day 2 range is missing an end number.");
       return 0;
     }
+    if (bound < 0) {
+      setErr(err, errSize, "Day 2 range bounds must fit in 128 bits.");
+      return 0;
+    }
     ranges++;
     while (*p && *p != ',' && *p != '\n' && *p != '\r') {
       if (*p != ' ' && *p != '\t') {
@@ -137,22 +264,14 @@ static int validateDay3(const char *data, size_t size, char *err,
     setErr(err, errSize, "Day 3 input is empty.");
     return 0;
   }
+  static const ByteClass digitLines = {'0', '9', "\n\r"};
   int digits = 0;
-  for (const char *p = data; *p; ++p) {
-    if (*p == '\n') {
-      continue;
-    }
-    if (*p == '\r') {
-      continue;
-    }
-    if (*p >= '0' && *p <= '9') {
-      digits++;
-      continue;
-    }
-    setErr(err, errSize, "Day 3 expects only digits per line.");
+  size_t bad = classScan(data, size, &digitLines, &digits);
+  if (bad < size) {
+    setErrAt(err, errSize, "Day 3 expects only digits per line.", data, bad);
     return 0;
   }
-  if (digits == 0) {
+  if (!digits) {
     setErr(err, errSize, "Day 3 input has no digits.");
     return 0;
   }
@@ -165,18 +284,15 @@ static int validateDay4(const char *data, size_t size, char *err,
     setErr(err, errSize, "Day 4 input is empty.");
     return 0;
   }
-  size_t atCount = 0;
-  for (const char *p = data; *p; ++p) {
-    if (*p == '@') {
-      atCount++;
-    } else if (*p == '.' || *p == '\n' || *p == '\r') {
-      continue;
-    } else {
-      setErr(err, errSize, "Day 4 grid may only contain '.' and '@'.");
-      return 0;
-    }
+  static const ByteClass grid = {'@', '@', ".\n\r"};
+  int hasRoll = 0;
+  size_t bad = classScan(data, size, &grid, &hasRoll);
+  if (bad < size) {
+    setErrAt(err, errSize, "Day 4 grid may only contain '.' and '@'.", data,
+             bad);
+    return 0;
   }
-  if (atCount == 0) {
+  if (!hasRoll) {
     setErr(err, errSize, "Day 4 grid has no '@' cells.");
     return 0;
   }
@@ -369,17 +485,14 @@ static int validateDay7(const char *data, size_t size, char *err,
     setErr(err, errSize, "Day 7 input is empty.");
     return 0;
   }
+  static const ByteClass grid = {'S', 'S', ".^\n\r"};
   int hasStart = 0;
-  for (const char *p = data; *p; ++p) {
-    if (*p == 'S') {
-      hasStart = 1;
-    } else if (*p == '.' || *p == '^' || *p == '\n' || *p == '\r') {
-      continue;
-    } else {
-      setErr(err, errSize,
-             "Day 7 grid may only contain '.', '^', 'S' and newlines.");
-      return 0;
-    }
+  size_t bad = classScan(data, size, &grid, &hasStart);
+  if (bad < size) {
+    setErrAt(err, errSize,
+             "Day 7 grid may only contain '.', '^', 'S' and newlines.", data,
+             bad);
+    return 0;
   }
   if (!hasStart) {
     setErr(err, errSize, "Day 7 grid is missing the start marker 'S'.");
@@ -624,269 +737,6 @@ static int validateDay10(const char *data, size_t size, char *err,
   return 1;
 }
 
-static int isNameChar(char c) {
-  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
-}
-
-static int validateDay11(const char *data, size_t size, char *err,
-                         size_t errSize) {
-  if (size == 0) {
-    setErr(err, errSize, "Day 11 input is empty.");
-    return 0;
-  }
-  const char *p = data;
-  size_t edges = 0;
-  while (*p) {
-    const char *start = p;
-    while (*p && *p != '\n') {
-      p++;
-    }
-    size_t len = (size_t)(p - start);
-    if (len > 0) {
-      const char *colon = memchr(start, ':', len);
-      if (!colon || colon == start) {
-        setErr(err, errSize,
-               "Day 11 lines must look like 'node: neighbor neighbor'.");
-        return 0;
-      }
-      for (const char *q = start; q < colon; ++q) {
-        if (!isNameChar(*q)) {
-          setErr(err, errSize,
-                 "Day 11 node names must be alphabetic tokens.");
-          return 0;
-        }
-      }
-      int neighbors = 0;
-      const char *q = colon + 1;
-      while (q < start + len) {
-        while (q < start + len && (*q == ' ' || *q == '\t')) {
-          q++;
-        }
-        if (q >= start + len) {
-          break;
-        }
-        const char *tok = q;
-        while (q < start + len && *q != ' ' && *q != '\t') {
-          if (!isNameChar(*q)) {
-            setErr(err, errSize,
-                   "Day 11 neighbor names must be alphabetic tokens.");
-            return 0;
-          }
-          q++;
-        }
-        if (q > tok) {
-          neighbors++;
-        }
-      }
-      if (neighbors == 0) {
-        setErr(err, errSize,
-               "Day 11 lines need at least one neighbor after ':'.");
-        return 0;
-      }
-      edges += (size_t)neighbors;
-    }
-    if (*p == '\n') {
-      p++;
-    }
-  }
-  if (edges == 0) {
-    setErr(err, errSize, "Day 11 input lists no edges.");
-    return 0;
-  }
-  return 1;
-}
-
-typedef struct {
-  const char *ptr;
-  size_t len;
-} LineView;
-
-static int validateDay12(const char *data, size_t size, char *err,
-                         size_t errSize) {
-  if (size == 0) {
-    setErr(err, errSize, "Day 12 input is empty.");
-    return 0;
-  }
-  // First pass: collect lines
-  size_t lineCount = 0;
-  for (const char *p = data; *p; ++p) {
-    if (*p == '\n') {
-      lineCount++;
-    }
-  }
-  lineCount++; // last line
-
-  LineView *lines = malloc(lineCount * sizeof(LineView));
-  if (!lines) {
-    setErr(err, errSize, "Allocation failure while validating Day 12 input.");
-    return 0;
-  }
-
-  size_t idx = 0;
-  const char *p = data;
-  while (*p) {
-    const char *start = p;
-    while (*p && *p != '\n') {
-      p++;
-    }
-    lines[idx].ptr = start;
-    lines[idx].len = (size_t)(p - start);
-    idx++;
-    if (*p == '\n') {
-      p++;
-    }
-  }
-  if (idx < lineCount) {
-    lines[idx].ptr = p;
-    lines[idx].len = 0;
-  }
-
-  size_t lineIdx = 0;
-  int shapeId = 0;
-  int shapeCount = 0;
-
-  // Parse shapes
-  while (lineIdx < lineCount) {
-    while (lineIdx < lineCount && lines[lineIdx].len == 0) {
-      lineIdx++;
-    }
-    if (lineIdx >= lineCount) {
-      break;
-    }
-    const LineView *lv = &lines[lineIdx];
-    const char *colon = memchr(lv->ptr, ':', lv->len);
-    const char *xposHeader = memchr(lv->ptr, 'x', lv->len);
-    if (!colon || (xposHeader && xposHeader < colon)) {
-      break; // likely start of regions
-    }
-    // Header should be "<id>:"
-    char headerBuf[16];
-    if (lv->len >= sizeof(headerBuf)) {
-      setErr(err, errSize, "Day 12 shape header is too long.");
-      free(lines);
-      return 0;
-    }
-    memcpy(headerBuf, lv->ptr, lv->len);
-    headerBuf[lv->len] = '\0';
-    int parsedId = atoi(headerBuf);
-    if (parsedId != shapeId) {
-      setErr(err, errSize, "Day 12 shape IDs must start at 0 and increment.");
-      free(lines);
-      return 0;
-    }
-    shapeId++;
-    lineIdx++;
-
-    for (const char *q = colon + 1; q < lv->ptr + lv->len; ++q) {
-      if (*q != ' ' && *q != '\t') {
-        setErr(err, errSize,
-               "Day 12 shape header should be just '<id>:' with no extras.");
-        free(lines);
-        return 0;
-      }
-    }
-
-    int rows = 0;
-    while (lineIdx < lineCount && lines[lineIdx].len > 0 &&
-           memchr(lines[lineIdx].ptr, ':', lines[lineIdx].len) == NULL &&
-           memchr(lines[lineIdx].ptr, 'x', lines[lineIdx].len) == NULL) {
-      const LineView *row = &lines[lineIdx];
-      for (size_t i = 0; i < row->len; ++i) {
-        char c = row->ptr[i];
-        if (c != '.' && c != '#') {
-          setErr(err, errSize,
-                 "Day 12 shape rows must only contain '.' or '#'.");
-          free(lines);
-          return 0;
-        }
-      }
-      rows++;
-      lineIdx++;
-    }
-    if (rows == 0) {
-      setErr(err, errSize, "Day 12 shape definition has no rows.");
-      free(lines);
-      return 0;
-    }
-    shapeCount++;
-  }
-
-  if (shapeCount == 0) {
-    setErr(err, errSize, "Day 12 input defines no shapes.");
-    free(lines);
-    return 0;
-  }
-
-  // Parse regions
-  int regions = 0;
-  for (; lineIdx < lineCount; ++lineIdx) {
-    if (lines[lineIdx].len == 0) {
-      continue;
-    }
-    const LineView *lv = &lines[lineIdx];
-    const char *xpos = memchr(lv->ptr, 'x', lv->len);
-    const char *colon = memchr(lv->ptr, ':', lv->len);
-    if (!xpos || !colon || xpos > colon) {
-      setErr(err, errSize,
-             "Day 12 region lines must look like 'WxH: counts...'.");
-      free(lines);
-      return 0;
-    }
-    unsigned long long w = 0, h = 0;
-    const char *ptr = lv->ptr;
-    if (!parseUnsigned(&ptr, &w) || ptr != xpos) {
-      setErr(err, errSize, "Day 12 region width is invalid.");
-      free(lines);
-      return 0;
-    }
-    ptr++; // skip 'x'
-    if (!parseUnsigned(&ptr, &h) || ptr != colon) {
-      setErr(err, errSize, "Day 12 region height is invalid.");
-      free(lines);
-      return 0;
-    }
-    ptr++; // skip ':'
-    int counts = 0;
-    while (ptr < lv->ptr + lv->len) {
-      while (ptr < lv->ptr + lv->len &&
-             (*ptr == ' ' || *ptr == '\t')) {
-        ptr++;
-      }
-      if (ptr >= lv->ptr + lv->len) {
-        break;
-      }
-      unsigned long long c;
-      if (!parseUnsigned(&ptr, &c)) {
-        setErr(err, errSize,
-               "Day 12 region counts must be integers separated by spaces.");
-        free(lines);
-        return 0;
-      }
-      counts++;
-    }
-    if (counts == 0) {
-      setErr(err, errSize,
-             "Day 12 region line has no shape counts listed.");
-      free(lines);
-      return 0;
-    }
-    if (counts != shapeCount) {
-      setErr(err, errSize,
-             "Day 12 region count length must match number of shapes.");
-      free(lines);
-      return 0;
-    }
-    regions++;
-  }
-
-  free(lines);
-  if (regions == 0) {
-    setErr(err, errSize, "Day 12 input lists no regions.");
-    return 0;
-  }
-  return 1;
-}
-
 int validateInputForDay(unsigned int day, const char *data, size_t size,
                         char *errBuf, size_t errBufSize) {
   switch (day) {
@@ -911,11 +761,13 @@ int validateInputForDay(unsigned int day, const char *data, size_t size,
   case 10:
     return validateDay10(data, size, errBuf, errBufSize);
   case 11:
-    return validateDay11(data, size, errBuf, errBufSize);
+    return day11Validate(data, size, errBuf, errBufSize);
   case 12:
-    return validateDay12(data, size, errBuf, errBufSize);
+    return day12Validate(data, size, errBuf, errBufSize);
   default:
     setErr(errBuf, errBufSize, "Unsupported day for validation.");
     return 0;
   }
 }
+
+int validateFusedWithParse(unsigned int day) { return day == 11 || day == 12; }
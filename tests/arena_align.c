@@ -0,0 +1,43 @@
+// Checks that arenaAllocAligned honours alignments above max_align_t after
+// odd-sized allocations, across block growth and mark/release.
+#include "tools.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+static int checkAligned(Arena *arena, size_t align, int rounds) {
+  int bad = 0;
+  for (int i = 0; i < rounds; ++i) {
+    if (!arenaAlloc(arena, (size_t)(i % 37) + 1)) {
+      return -1;
+    }
+    unsigned char *p = arenaAllocAligned(arena, (size_t)(i % 61) + 1, align);
+    if (!p) {
+      return -1;
+    }
+    if ((uintptr_t)p % align != 0) {
+      bad++;
+    }
+    p[0] = 1;
+  }
+  return bad;
+}
+
+int main(void) {
+  Arena arena = arenaCreate(0);
+  int failed = 0;
+  for (size_t align = 32; align <= 4096; align *= 2) {
+    ArenaMark mark = arenaMark(&arena);
+    int bad = checkAligned(&arena, align, 2000);
+    arenaRelease(&arena, mark);
+    if (bad != 0) {
+      fprintf(stderr, "FAIL arena align=%zu misaligned=%d\n", align, bad);
+      failed = 1;
+    }
+  }
+  arenaDestroy(&arena);
+  if (!failed) {
+    printf("ok arena aligned allocations\n");
+  }
+  return failed;
+}
@@ -4,8 +4,9 @@ ROOT="$(dirname "$0")/.."
 BIN="$ROOT/bin/aoc"
 
 run_line() {
-  day=$1; part=$2; input=$3; expected=$4
-  line=$($BIN --day "$day" --part "$part" --input "$input" | grep "[Part $part]")
+  day=$1; part=$2; input=$3; expected=$4; shift 4
+  line=$($BIN --day "$day" --part "$part" --input "$input" "$@" |
+    grep "[Part $part]")
   out=$(echo "$line" | awk '{print $3}')
   if [[ "$out" != "$expected" ]]; then
     echo "FAIL day=$day part=$part expected=$expected got=$out" >&2
@@ -14,6 +15,35 @@ run_line() {
   echo "ok day=$day part=$part=$out"
 }
 
+run_query() {
+  input=$1; queries=$2; num=$3; expected=$4
+  line=$($BIN --day 11 --input "$input" --queries "$queries" |
+    grep -F "[Query $num]")
+  out=$(echo "$line" | awk '{print $3}')
+  if [[ "$out" != "$expected" ]]; then
+    echo "FAIL day=11 query=$num expected=$expected got=$out" >&2
+    return 1
+  fi
+  echo "ok day=11 query=$num=$out"
+}
+
+run_fail() {
+  day=$1; part=$2; input=$3; shift 3
+  if $BIN --day "$day" --part "$part" --input "$input" "$@" >/dev/null 2>&1; then
+    echo "FAIL day=$day part=$part expected an error for $input" >&2
+    return 1
+  fi
+  echo "ok day=$day part=$part rejected"
+}
+
+# Arena allocator
+UNIT_DIR="$(mktemp -d)"
+trap 'rm -rf "$UNIT_DIR"' EXIT
+UNIT="$UNIT_DIR/arena_align"
+${CC:-cc} -std=c11 -pthread -I"$ROOT/include" "$ROOT/tests/arena_align.c" \
+  "$ROOT/src/tools.c" "$ROOT/src/lines.c" "$ROOT/src/parallel.c" -o "$UNIT"
+"$UNIT"
+
 # Day 1 simple sample
 run_line 1 1 "$ROOT/tests/day1_sample.txt" 0
 run_line 1 2 "$ROOT/tests/day1_sample.txt" 0
@@ -25,11 +55,17 @@ if [[ -f "$ROOT/input.txt" ]]; then
   run_line 2 1 "$ROOT/input.txt" "$d2p1"
   run_line 2 2 "$ROOT/input.txt" "$d2p2"
 fi
+run_line 2 1 "$ROOT/tests/day2_wide.txt" 495495495495495495500040950040950040945040950040950040950
+run_line 2 2 "$ROOT/tests/day2_wide.txt" 495496024950991248695167087565590926165979237476353965719
 
 # Day 3 sample
 run_line 3 1 "$ROOT/tests/day3_sample.txt" 357
 run_line 3 2 "$ROOT/tests/day3_sample.txt" 3121910778619
 run_line 3 2 "$ROOT/tests/day3_edge_short.txt" 1123456789032
+run_line 3 1 "$ROOT/tests/day3_long_lines.txt" 385
+run_line 3 2 "$ROOT/tests/day3_long_lines.txt" 3888888777329
+run_line 3 2 "$ROOT/tests/day3_sample.txt" 3205 --digits 3
+run_line 3 2 "$ROOT/tests/day3_long_lines.txt" 388885 --digits 5
 
 # Day 4 sample
 run_line 4 1 "$ROOT/tests/day4_sample.txt" 13
@@ -41,6 +77,9 @@ run_line 5 1 "$ROOT/tests/day5_sample.txt" 3
 run_line 5 2 "$ROOT/tests/day5_sample.txt" 14
 run_line 5 1 "$ROOT/tests/day5_edge_ranges.txt" 6
 run_line 5 2 "$ROOT/tests/day5_edge_ranges.txt" 6
+run_line 5 1 "$ROOT/tests/day5_join.txt" 30
+run_line 5 1 "$ROOT/tests/day5_blanks.txt" 3
+run_line 5 2 "$ROOT/tests/day5_blanks.txt" 14
 
 # Day 6 sample
 run_line 6 1 "$ROOT/tests/day6_sample.txt" 4277556
@@ -49,14 +88,18 @@ run_line 6 2 "$ROOT/tests/day6_sample.txt" 3263827
 # Day 7 sample
 run_line 7 1 "$ROOT/tests/day7_sample.txt" 21
 run_line 7 2 "$ROOT/tests/day7_sample.txt" 40
+run_fail 7 1 "$ROOT/tests/day7_invalid.txt"
 
 # Day 8 sample (uses 10 edges)
 run_line 8 1 "$ROOT/tests/day8_sample.txt" 40
 run_line 8 2 "$ROOT/tests/day8_sample.txt" 25272
+run_line 8 2 "$ROOT/tests/day8_blanks.txt" 25272
 
 # Day 9 sample
 run_line 9 1 "$ROOT/tests/day9_sample.txt" 50
 run_line 9 2 "$ROOT/tests/day9_sample.txt" 24
+run_line 9 1 "$ROOT/tests/day9_blanks.txt" 50
+run_line 9 2 "$ROOT/tests/day9_blanks.txt" 24
 
 # Day 10 sample
 run_line 10 1 "$ROOT/tests/day10_sample.txt" 7
@@ -65,6 +108,15 @@ run_line 10 2 "$ROOT/tests/day10_sample.txt" 33
 # Day 11 sample
 run_line 11 1 "$ROOT/tests/day11_sample.txt" 5
 run_line 11 2 "$ROOT/tests/day11_part2_sample.txt" 2
+run_fail 11 1 "$ROOT/tests/day11_cycle.txt"
+run_query "$ROOT/tests/day11_part2_sample.txt" "$ROOT/tests/day11_queries.txt" 2 8
+run_query "$ROOT/tests/day11_part2_sample.txt" "$ROOT/tests/day11_queries.txt" 3 2
 
 # Day 12 sample (count of regions that fit)
 run_line 12 1 "$ROOT/tests/day12_sample.txt" 2
+run_line 12 1 "$ROOT/tests/day12_exact.txt" 2
+run_line 12 1 "$ROOT/tests/day12_empty_shape.txt" 3
+run_line 12 1 "$ROOT/tests/day12_large.txt" 2
+run_fail 12 1 "$ROOT/tests/day12_sample.txt" --node-budget 1
+run_fail 12 1 "$ROOT/tests/day12_invalid.txt"
+run_fail 12 2 "$ROOT/tests/day12_invalid.txt"